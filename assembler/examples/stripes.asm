@@ -0,0 +1,47 @@
+; Synthetic workload: redraws the Space Invaders framebuffer with a
+; scrolling stripe pattern, forever. It uses the same memory map and
+; interrupt vectors as the real ROMs, so the emulator and 8080-bench can run it.
+;
+;   ./asm8080 examples/stripes.asm -o stripes.bin
+
+VRAM    EQU 2400h
+VSIZE   EQU 1C00h
+STACK   EQU 2400h
+phase   EQU 2000h               ; first byte of work RAM
+
+        ORG 0
+        JMP start
+
+        ORG 8                   ; RST 1, mid-screen
+        EI
+        RET
+
+        ORG 10h                 ; RST 2, vblank: advance the pattern
+        PUSH PSW
+        LDA phase
+        INR A
+        STA phase
+        POP PSW
+        EI
+        RET
+
+start:  LXI SP, STACK
+        EI
+
+frame:  LXI H, VRAM
+        LXI D, VSIZE
+        LDA phase
+        MOV B, A
+
+fill:   MOV A, L
+        ADD B
+        ANI 0F0h
+        MOV M, A
+        INX H
+        DCX D
+        MOV A, D
+        ORA E
+        JNZ fill
+        JMP frame
+
+        END
@@ -0,0 +1,722 @@
+// asm8080 - a small two-pass Intel 8080 assembler.
+//
+//   ./asm8080 <source.asm> [-o out.bin] [-l listing.txt] [-s symbols.sym]
+//
+// Writes a raw binary (default out.bin) that open_rom() loads as-is. The
+// emulator loads a ROM at 0x0000, so the image always starts there and runs
+// to the highest address written; everything not assembled is zero-filled. -s writes every label and EQU as an
+// "address name" symbol file for the disassembler and the emulator's trace.
+//
+// Syntax, one statement per line, case-insensitive:
+//
+//   label:  MNEMONIC operands      ; comment
+//   name    EQU  expression
+//           ORG  expression
+//           DB   expression | "string", ...
+//           DW   expression, ...
+//           DS   expression        ; reserve (zero) bytes
+//           END
+//
+// Expressions take decimal, 0x1F / 1Fh / $1F hex, 'c' characters, symbols
+// and $ (address of the current statement), combined with + - * / and
+// parentheses. EQU, ORG and DS values must be known when the line is first
+// seen; everything else may refer forward.
+//
+// Mnemonics and operand forms come from the shared opcode table in
+// common/opcodes.def.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "../../common/opcodes.h"
+
+#define MAX_LINE        512
+#define MAX_OPERANDS    64
+#define MAX_SYMBOLS     4096
+#define MAX_NAME        32
+
+typedef struct {
+    char name[MAX_NAME];
+    uint16_t value;
+} symbol;
+
+static symbol symbols[MAX_SYMBOLS];
+static int symbol_count = 0;
+
+static uint8_t image[0x10000];
+static int image_low = 0x10000;
+static int image_high = 0;
+
+static int pass;
+static int pc;
+static int statement_pc;
+static int errors = 0;
+static bool ended;
+
+static const char* source_name;
+static int line_number;
+
+static FILE* listing = NULL;
+static uint8_t line_bytes[8];
+static int line_byte_count;
+
+static void error(const char* message, const char* detail) {
+    fprintf(stderr, "%s:%d: %s%s%s\n", source_name, line_number, message,
+        detail ? " " : "", detail ? detail : "");
+    errors++;
+}
+
+static bool same_name(const char* a, const char* b) {
+    for (; *a && *b; a++, b++) {
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*b)) {
+            return false;
+        }
+    }
+    return *a == *b;
+}
+
+static symbol* find_symbol(const char* name) {
+    for (int i = 0; i < symbol_count; i++) {
+        if (same_name(symbols[i].name, name)) {
+            return &symbols[i];
+        }
+    }
+    return NULL;
+}
+
+static void define_symbol(const char* name, int value) {
+
+    symbol* existing = find_symbol(name);
+
+    if (pass == 2) {
+        if (existing && existing->value != (uint16_t)value) {
+            error("symbol moved between passes:", name);
+        }
+        return;
+    }
+
+    if (existing) {
+        error("symbol defined twice:", name);
+        return;
+    }
+
+    if (strlen(name) >= MAX_NAME || symbol_count == MAX_SYMBOLS) {
+        error("symbol name too long or too many symbols:", name);
+        return;
+    }
+
+    strcpy(symbols[symbol_count].name, name);
+    symbols[symbol_count].value = (uint16_t)value;
+    symbol_count++;
+}
+
+static void emit(int value) {
+
+    if (pc > 0xFFFF) {
+        error("program runs past 0xFFFF", NULL);
+        return;
+    }
+
+    if (pass == 2) {
+        image[pc] = (uint8_t)value;
+
+        if (pc < image_low) {
+            image_low = pc;
+        }
+        if (pc + 1 > image_high) {
+            image_high = pc + 1;
+        }
+        if (line_byte_count < (int)sizeof(line_bytes)) {
+            line_bytes[line_byte_count++] = (uint8_t)value;
+        }
+    }
+
+    pc++;
+}
+
+// --- expressions ---
+
+typedef struct {
+    const char* at;
+    bool resolved;      // false if an undefined symbol was used
+    bool failed;
+} expr_state;
+
+static void skip_spaces(expr_state* e) {
+    while (*e->at == ' ' || *e->at == '\t') {
+        e->at++;
+    }
+}
+
+static bool is_symbol_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+static int parse_number(expr_state* e) {
+
+    const char* start = e->at;
+    const char* end = start;
+
+    while (isalnum((unsigned char)*end)) {
+        end++;
+    }
+    e->at = end;
+
+    char text[MAX_NAME];
+    int length = end - start;
+
+    if (length >= MAX_NAME) {
+        e->failed = true;
+        return 0;
+    }
+
+    memcpy(text, start, length);
+    text[length] = '\0';
+
+    char* stop;
+    long value;
+
+    if (length > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        value = strtol(text + 2, &stop, 16);
+    } else if (toupper((unsigned char)text[length - 1]) == 'H') {
+        text[length - 1] = '\0';
+        value = strtol(text, &stop, 16);
+    } else {
+        value = strtol(text, &stop, 10);
+    }
+
+    if (*stop != '\0') {
+        error("bad number:", start);
+        e->failed = true;
+    }
+
+    return (int)value;
+}
+
+static int parse_expression(expr_state* e);
+
+static int parse_primary(expr_state* e) {
+
+    skip_spaces(e);
+    char c = *e->at;
+
+    if (c == '(') {
+        e->at++;
+        int value = parse_expression(e);
+        skip_spaces(e);
+        if (*e->at != ')') {
+            error("missing )", NULL);
+            e->failed = true;
+        } else {
+            e->at++;
+        }
+        return value;
+    }
+
+    if (c == '-') {
+        e->at++;
+        return -parse_primary(e);
+    }
+
+    if (c == '+') {
+        e->at++;
+        return parse_primary(e);
+    }
+
+    if (c == '\'' && e->at[1] && e->at[2] == '\'') {
+        int value = (unsigned char)e->at[1];
+        e->at += 3;
+        return value;
+    }
+
+    if (c == '$') {
+        e->at++;
+        if (isxdigit((unsigned char)*e->at)) {
+            char* stop;
+            int value = (int)strtol(e->at, &stop, 16);
+            e->at = stop;
+            return value;
+        }
+        return statement_pc;
+    }
+
+    if (isdigit((unsigned char)c)) {
+        return parse_number(e);
+    }
+
+    if (is_symbol_char(c)) {
+        char name[MAX_NAME];
+        int length = 0;
+
+        while (is_symbol_char(*e->at)) {
+            if (length < MAX_NAME - 1) {
+                name[length++] = *e->at;
+            }
+            e->at++;
+        }
+        name[length] = '\0';
+
+        symbol* s = find_symbol(name);
+        if (!s) {
+            // forward references are expected in pass 1
+            if (pass == 2) {
+                error("undefined symbol:", name);
+            }
+            e->resolved = false;
+            return 0;
+        }
+        return s->value;
+    }
+
+    error("bad expression:", e->at);
+    e->failed = true;
+    return 0;
+}
+
+static int parse_term(expr_state* e) {
+
+    int value = parse_primary(e);
+
+    for (;;) {
+        skip_spaces(e);
+        char op = *e->at;
+
+        if (op != '*' && op != '/') {
+            return value;
+        }
+
+        e->at++;
+        int rhs = parse_primary(e);
+
+        if (op == '*') {
+            value *= rhs;
+        } else if (rhs != 0) {
+            value /= rhs;
+        } else if (e->resolved) {
+            error("division by zero", NULL);
+            e->failed = true;
+        }
+    }
+}
+
+static int parse_expression(expr_state* e) {
+
+    int value = parse_term(e);
+
+    for (;;) {
+        skip_spaces(e);
+        char op = *e->at;
+
+        if (op != '+' && op != '-') {
+            return value;
+        }
+
+        e->at++;
+        int rhs = parse_term(e);
+        value = op == '+' ? value + rhs : value - rhs;
+    }
+}
+
+// Evaluates a whole operand. Returns false on a syntax error, or if
+// `required` is set and the value depends on a symbol not yet defined.
+static bool evaluate(const char* text, bool required, int* value) {
+
+    expr_state e = { text, true, false };
+    *value = parse_expression(&e);
+    skip_spaces(&e);
+
+    if (!e.failed && *e.at != '\0') {
+        error("unexpected text in expression:", e.at);
+        e.failed = true;
+    }
+
+    if (required && !e.resolved) {
+        if (pass == 1) {
+            error("value must be defined before this line:", text);
+        }
+        return false;
+    }
+
+    return !e.failed;
+}
+
+static void emit_byte_operand(const char* text) {
+    int value;
+    if (evaluate(text, false, &value) && (value < -128 || value > 255)) {
+        error("byte value out of range:", text);
+    }
+    emit(value);
+}
+
+static void emit_word_operand(const char* text) {
+    int value;
+    if (evaluate(text, false, &value) && (value < -32768 || value > 0xFFFF)) {
+        error("word value out of range:", text);
+    }
+    emit(value & 0xFF);
+    emit((value >> 8) & 0xFF);
+}
+
+// --- statements ---
+
+static char* trim(char* text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+
+    return text;
+}
+
+// Splits the operand field on commas outside quotes and parentheses.
+static int split_operands(char* text, char** operands) {
+
+    int count = 0;
+    int depth = 0;
+    char quote = 0;
+
+    text = trim(text);
+    if (*text == '\0') {
+        return 0;
+    }
+
+    operands[count++] = text;
+
+    for (char* c = text; *c; c++) {
+        if (quote) {
+            if (*c == quote) {
+                quote = 0;
+            }
+        } else if (*c == '"' || *c == '\'') {
+            quote = *c;
+        } else if (*c == '(') {
+            depth++;
+        } else if (*c == ')') {
+            depth--;
+        } else if (*c == ',' && depth == 0 && count < MAX_OPERANDS) {
+            *c = '\0';
+            operands[count++] = c + 1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        operands[i] = trim(operands[i]);
+    }
+
+    return count;
+}
+
+// Does the operand list start with the table's fixed operands ("B,C")?
+static bool match_registers(const char* registers, char** operands, int count, int* used) {
+
+    *used = 0;
+
+    while (*registers) {
+        const char* comma = strchr(registers, ',');
+        int length = comma ? (int)(comma - registers) : (int)strlen(registers);
+
+        if (*used == count) {
+            return false;
+        }
+
+        const char* operand = operands[*used];
+        if ((int)strlen(operand) != length) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            if (toupper((unsigned char)operand[i]) != registers[i]) {
+                return false;
+            }
+        }
+
+        (*used)++;
+        registers += length + (comma ? 1 : 0);
+    }
+
+    return true;
+}
+
+static bool assemble_instruction(const char* mnemonic, char** operands, int count) {
+
+    bool known = false;
+
+    // the first match is the documented encoding (0x00 NOP rather than 0x08)
+    for (int op = 0; op < 256; op++) {
+        const opcode_info* info = &opcode_table[op];
+        int used;
+
+        if (!same_name(info->mnemonic, mnemonic)) {
+            continue;
+        }
+        known = true;
+
+        if (!match_registers(info->registers, operands, count, &used)) {
+            continue;
+        }
+        if (count != used + (info->operand != OPERAND_NONE ? 1 : 0)) {
+            continue;
+        }
+
+        emit(op);
+
+        if (info->operand == OPERAND_BYTE || info->operand == OPERAND_PORT) {
+            emit_byte_operand(operands[used]);
+        } else if (info->operand != OPERAND_NONE) {
+            emit_word_operand(operands[used]);
+        }
+
+        return true;
+    }
+
+    error(known ? "bad operands for" : "unknown mnemonic", mnemonic);
+    return false;
+}
+
+static void assemble_data(const char* directive, char** operands, int count) {
+
+    bool words = same_name(directive, "DW");
+
+    for (int i = 0; i < count; i++) {
+        const char* operand = operands[i];
+        size_t length = strlen(operand);
+
+        if (!words && length >= 2 && (operand[0] == '"' || (operand[0] == '\'' && length != 3)) &&
+            operand[length - 1] == operand[0]) {
+            for (size_t c = 1; c + 1 < length; c++) {
+                emit((unsigned char)operand[c]);
+            }
+        } else if (words) {
+            emit_word_operand(operand);
+        } else {
+            emit_byte_operand(operand);
+        }
+    }
+}
+
+static void assemble_line(char* line) {
+
+    // strip the comment, ignoring semicolons inside quotes
+    char quote = 0;
+    for (char* c = line; *c; c++) {
+        if (quote) {
+            if (*c == quote) {
+                quote = 0;
+            }
+        } else if (*c == '"' || *c == '\'') {
+            quote = *c;
+        } else if (*c == ';') {
+            *c = '\0';
+            break;
+        }
+    }
+
+    statement_pc = pc;
+    char* text = trim(line);
+    char* label = NULL;
+
+    // "label:" or "name EQU value"
+    char* end = text;
+    while (is_symbol_char(*end)) {
+        end++;
+    }
+
+    if (end > text && *end == ':') {
+        *end = '\0';
+        label = text;
+        text = trim(end + 1);
+    } else if (end > text && (*end == ' ' || *end == '\t')) {
+        char* next = trim(end);
+        if (toupper((unsigned char)next[0]) == 'E' && toupper((unsigned char)next[1]) == 'Q' &&
+            toupper((unsigned char)next[2]) == 'U' && (next[3] == ' ' || next[3] == '\t')) {
+            *end = '\0';
+            label = text;
+            text = next;
+        }
+    }
+
+    char* mnemonic = text;
+    char* rest = text;
+    while (*rest && !isspace((unsigned char)*rest)) {
+        rest++;
+    }
+    if (*rest) {
+        *rest++ = '\0';
+    }
+
+    char* operands[MAX_OPERANDS];
+    int count = split_operands(rest, operands);
+
+    if (same_name(mnemonic, "EQU")) {
+        int value;
+        if (!label) {
+            error("EQU needs a name", NULL);
+        } else if (count == 1 && evaluate(operands[0], true, &value)) {
+            define_symbol(label, value);
+        }
+        return;
+    }
+
+    if (label) {
+        define_symbol(label, pc);
+    }
+
+    if (*mnemonic == '\0') {
+        return;
+    }
+
+    if (same_name(mnemonic, "ORG")) {
+        int value;
+        if (count == 1 && evaluate(operands[0], true, &value)) {
+            pc = value & 0xFFFF;
+        }
+    } else if (same_name(mnemonic, "DB") || same_name(mnemonic, "DW")) {
+        assemble_data(mnemonic, operands, count);
+    } else if (same_name(mnemonic, "DS")) {
+        int value;
+        if (count == 1 && evaluate(operands[0], true, &value)) {
+            for (int i = 0; i < value; i++) {
+                emit(0);
+            }
+        }
+    } else if (same_name(mnemonic, "END")) {
+        ended = true;
+    } else {
+        assemble_instruction(mnemonic, operands, count);
+    }
+}
+
+static void write_listing_line(const char* source) {
+
+    if (line_byte_count == 0) {
+        fprintf(listing, "%-20s %s", "", source);
+        return;
+    }
+
+    char bytes[20] = "";
+    for (int i = 0; i < line_byte_count && i < 4; i++) {
+        sprintf(bytes + i * 3, "%02x ", line_bytes[i]);
+    }
+
+    fprintf(listing, "%04x  %-14s %s", statement_pc, bytes, source);
+}
+
+static void run_pass(FILE* source) {
+
+    char line[MAX_LINE];
+    char copy[MAX_LINE];
+
+    rewind(source);
+    pc = 0;
+    line_number = 0;
+    ended = false;
+
+    while (!ended && fgets(line, sizeof(line), source)) {
+        line_number++;
+        line_byte_count = 0;
+
+        strcpy(copy, line);
+        assemble_line(line);
+
+        if (pass == 2 && listing) {
+            write_listing_line(copy);
+        }
+    }
+}
+
+static void write_symbols(const char* path) {
+
+    FILE* file = fopen(path, "w");
+
+    if (!file) {
+        printf("could not write %s\n", path);
+        return;
+    }
+
+    for (int i = 0; i < symbol_count; i++) {
+        fprintf(file, "%04x %s\n", symbols[i].value, symbols[i].name);
+    }
+
+    fclose(file);
+}
+
+int main(int argc, char** argv) {
+
+    const char* output_path = "out.bin";
+    const char* listing_path = NULL;
+    const char* symbols_path = NULL;
+    source_name = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            listing_path = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            symbols_path = argv[++i];
+        } else {
+            source_name = argv[i];
+        }
+    }
+
+    if (!source_name) {
+        printf("usage: asm8080 <source.asm> [-o out.bin] [-l listing.txt] [-s symbols.sym]\n");
+        return 1;
+    }
+
+    FILE* source = fopen(source_name, "r");
+
+    if (!source) {
+        printf("could not open %s\n", source_name);
+        return 1;
+    }
+
+    if (listing_path) {
+        listing = fopen(listing_path, "w");
+    }
+
+    for (pass = 1; pass <= 2 && errors == 0; pass++) {
+        run_pass(source);
+    }
+
+    fclose(source);
+
+    if (listing) {
+        fclose(listing);
+    }
+
+    if (errors) {
+        fprintf(stderr, "%d error%s\n", errors, errors == 1 ? "" : "s");
+        return 1;
+    }
+
+    FILE* output = fopen(output_path, "wb");
+
+    if (!output) {
+        printf("could not write %s\n", output_path);
+        return 1;
+    }
+
+    // from 0x0000 even when the first ORG is higher, so every byte lands at
+    // its own address when loaded
+    fwrite(image, 1, image_high, output);
+    fclose(output);
+
+    if (symbols_path) {
+        write_symbols(symbols_path);
+    }
+
+    printf("%s: %d bytes, code at 0x%04x-0x%04x, %d symbols\n", output_path,
+        image_high,
+        image_high > image_low ? image_low : 0,
+        image_high > image_low ? image_high - 1 : 0, symbol_count);
+
+    return 0;
+}
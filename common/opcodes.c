@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+#include "opcodes.h"
+
+const opcode_info opcode_table[256] = {
+#define OPCODE(code, mnemonic, registers, operand, length, cycles, taken, flags, flow) \
+    [code] = { mnemonic, registers, OPERAND_##operand, length, cycles, taken, FLAGS_##flags, FLOW_##flow },
+#include "opcodes.def"
+#undef OPCODE
+};
+
+int opcode_format(const uint8_t* code, const char* name, char* out) {
+
+    const opcode_info* info = &opcode_table[code[0]];
+    int used = sprintf(out, "%-6s", info->mnemonic);
+    const char* separator = " ";
+
+    // "B,C" in the table reads "B, C" in a listing
+    if (info->registers[0]) {
+        out[used++] = ' ';
+        for (const char* r = info->registers; *r; r++) {
+            out[used++] = *r;
+            if (*r == ',') {
+                out[used++] = ' ';
+            }
+        }
+        out[used] = '\0';
+        separator = ", ";
+    }
+
+    if (info->operand == OPERAND_BYTE || info->operand == OPERAND_PORT) {
+        used += sprintf(out + used, "%s%02x", separator, code[1]);
+    } else if (info->operand != OPERAND_NONE && name) {
+        used += sprintf(out + used, "%s%.*s", separator, OPCODE_NAME_MAX, name);
+    } else if (info->operand != OPERAND_NONE) {
+        used += sprintf(out + used, "%s%02x%02x", separator, code[2], code[1]);
+    }
+
+    // drop the mnemonic padding when nothing follows it
+    while (used > 0 && out[used - 1] == ' ') {
+        out[--used] = '\0';
+    }
+
+    return info->length;
+}
@@ -0,0 +1,64 @@
+#ifndef _OPCODES_H
+#define _OPCODES_H
+
+#include <stdint.h>
+
+// Opcode metadata shared by the emulator, the disassembler and the
+// assembler. The data itself is in opcodes.def.
+
+typedef enum {
+    OPERAND_NONE,       // nothing follows the opcode
+    OPERAND_BYTE,       // 8-bit immediate (MVI, ADI, ...)
+    OPERAND_PORT,       // 8-bit I/O port number (IN, OUT)
+    OPERAND_WORD,       // 16-bit immediate (LXI)
+    OPERAND_ADDRESS,    // 16-bit memory or jump address (JMP, CALL, LDA, ...)
+} operand_kind;
+
+// Condition bits, at their positions in the PSW flag byte
+#define FLAG_S      0x80
+#define FLAG_Z      0x40
+#define FLAG_A      0x10
+#define FLAG_P      0x04
+#define FLAG_C      0x01
+
+#define FLAGS_NONE  0
+#define FLAGS_C     FLAG_C
+#define FLAGS_SZAP  (FLAG_S | FLAG_Z | FLAG_A | FLAG_P)
+#define FLAGS_SZAPC (FLAGS_SZAP | FLAG_C)
+
+typedef enum {
+    FLOW_NEXT,          // continues with the next instruction
+    FLOW_JUMP,          // JMP
+    FLOW_JUMP_IF,       // Jcc: the target or the next instruction
+    FLOW_CALL,          // CALL: the target, and the next instruction on return
+    FLOW_CALL_IF,       // Ccc
+    FLOW_RET,           // RET
+    FLOW_RET_IF,        // Rcc: returns or continues
+    FLOW_RST,           // RST n: calls n * 8
+    FLOW_INDIRECT,      // PCHL: target only known at run time
+    FLOW_HALT,          // HLT: nothing follows until an interrupt
+} control_flow;
+
+typedef struct {
+    const char* mnemonic;
+    const char* registers;      // fixed operands, e.g. "B,C" or "SP" or "3"
+    operand_kind operand;
+    uint8_t length;
+    uint8_t cycles;             // conditional CALL / RET: not taken
+    uint8_t taken_cycles;       // conditional CALL / RET: taken
+    uint8_t flags;              // FLAG_* bits written
+    control_flow flow;
+} opcode_info;
+
+extern const opcode_info opcode_table[256];
+
+// Longest line opcode_format() produces, including the terminator
+#define OPCODE_NAME_MAX     40
+#define OPCODE_TEXT_MAX     (24 + OPCODE_NAME_MAX)
+
+// Formats the instruction at `code` as "MNEMONIC operands" (no address, no
+// newline) and returns its length in bytes. If `name` is not NULL it is
+// printed in place of a 16-bit operand.
+int opcode_format(const uint8_t* code, const char* name, char* out);
+
+#endif
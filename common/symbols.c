@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "symbols.h"
+
+static bool parse_address(const char* text, uint32_t* address) {
+
+    char* end;
+
+    if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text += 2;
+    }
+
+    *address = (uint32_t)strtoul(text, &end, 16);
+
+    if (end == text) {
+        return false;
+    }
+
+    return *end == '\0' || *end == 'h' || *end == 'H';
+}
+
+static void insert(symbol_table* table, uint32_t address, const char* name) {
+
+    uint32_t slot = symbols_hash(table, address);
+
+    while (table->names[slot] && table->addresses[slot] != address) {
+        slot = (slot + 1) & table->mask;
+    }
+
+    // a later line for the same address wins
+    if (!table->names[slot]) {
+        table->count++;
+    }
+
+    table->addresses[slot] = address;
+    table->names[slot] = name;
+}
+
+bool symbols_load(symbol_table* table, const char* path) {
+
+    memset(table, 0, sizeof(*table));
+
+    FILE* file = fopen(path, "r");
+
+    if (!file) {
+        fprintf(stderr, "could not open symbol file %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    table->text = malloc(size + 1);
+    size = fread(table->text, 1, size, file);
+    table->text[size] = '\0';
+    fclose(file);
+
+    // every symbol needs at least four characters of file, which bounds the
+    // table size; keep it at most half full
+    uint32_t capacity = 16;
+    table->bits = 4;
+    while (capacity < (uint32_t)size / 2) {
+        capacity *= 2;
+        table->bits++;
+    }
+
+    table->mask = capacity - 1;
+    table->addresses = malloc(capacity * sizeof(uint32_t));
+    table->names = calloc(capacity, sizeof(const char*));
+
+    int line_number = 0;
+
+    // split the text in place into address and name fields
+    for (char* line = table->text; line && *line; ) {
+        char* next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        line_number++;
+
+        char* address_text = strtok(line, " \t\r");
+        char* name = address_text ? strtok(NULL, " \t\r") : NULL;
+        uint32_t address;
+
+        if (address_text && address_text[0] != ';' && address_text[0] != '#') {
+            if (name && parse_address(address_text, &address)) {
+                insert(table, address, name);
+            } else {
+                fprintf(stderr, "%s:%d: expected \"address name\"\n", path, line_number);
+            }
+        }
+
+        line = next;
+    }
+
+    return true;
+}
+
+void symbols_free(symbol_table* table) {
+    free(table->addresses);
+    free(table->names);
+    free(table->text);
+    memset(table, 0, sizeof(*table));
+}
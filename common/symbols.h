@@ -0,0 +1,52 @@
+#ifndef _SYMBOLS_H
+#define _SYMBOLS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Address -> name table loaded from a symbol file, shared by the
+// disassembler listings and the emulator's trace. Lookups are a single
+// probe into an open-addressed hash table in the common case, so annotating
+// every line of a long trace stays cheap.
+//
+// Symbol file format, one symbol per line; blank lines and lines starting
+// with ';' or '#' are ignored:
+//
+//   01e4 draw_sprite
+//   0x20c0 wave_counter
+//   20f8h p1_score
+
+typedef struct {
+    uint32_t* addresses;
+    const char** names;         // NULL marks an empty slot
+    uint32_t mask;              // capacity - 1, capacity a power of two
+    uint32_t bits;              // log2 of the capacity
+    uint32_t count;
+    char* text;                 // storage for the names
+} symbol_table;
+
+bool symbols_load(symbol_table* table, const char* path);
+void symbols_free(symbol_table* table);
+
+// Fibonacci hashing: the multiply mixes the address into the high bits, so
+// the slot comes from the top `bits` bits of the product, not the bottom.
+static inline uint32_t symbols_hash(const symbol_table* table, uint32_t address) {
+    return (address * 2654435761u) >> (32 - table->bits);
+}
+
+static inline const char* symbols_lookup(const symbol_table* table, uint32_t address) {
+
+    if (!table || !table->count) {
+        return NULL;
+    }
+
+    for (uint32_t slot = symbols_hash(table, address); table->names[slot]; slot = (slot + 1) & table->mask) {
+        if (table->addresses[slot] == address) {
+            return table->names[slot];
+        }
+    }
+
+    return NULL;
+}
+
+#endif
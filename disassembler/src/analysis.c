@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "../../common/opcodes.h"
+
+typedef struct {
+	uint32_t* items;
+	size_t count;
+	size_t capacity;
+} worklist;
+
+static void push(worklist* list, uint32_t address) {
+
+	if (list->count == list->capacity) {
+		list->capacity = list->capacity ? list->capacity * 2 : 256;
+		list->items = realloc(list->items, list->capacity * sizeof(uint32_t));
+	}
+
+	list->items[list->count++] = address;
+}
+
+void analysis_init(analysis* a, const uint8_t* image, size_t size) {
+
+	a->image = image;
+	a->size = size;
+	a->kind = calloc(size ? size : 1, 1);
+	a->label = calloc(size ? size : 1, 1);
+	a->code_bytes = 0;
+	a->instructions = 0;
+	a->conflicts = 0;
+}
+
+void analysis_free(analysis* a) {
+	free(a->kind);
+	free(a->label);
+	a->kind = NULL;
+	a->label = NULL;
+}
+
+// Adds a branch target to the worklist, labelling it on the way.
+static void reach(analysis* a, worklist* list, uint32_t target, uint8_t label) {
+
+	if (target < a->size) {
+		a->label[target] |= label;
+		push(list, target);
+	}
+}
+
+// Decodes everything reachable from the worklist.
+static void drain(analysis* a, worklist* list) {
+
+	while (list->count) {
+		uint32_t pc = list->items[--list->count];
+
+		// decode a straight run until something ends it
+		while (pc < a->size && a->kind[pc] != BYTE_CODE) {
+			const uint8_t* code = a->image + pc;
+			const opcode_info* info = &opcode_table[code[0]];
+			uint32_t next = pc + info->length;
+
+			if (a->kind[pc] == BYTE_OPERAND || next > a->size) {
+				a->conflicts++;
+				break;
+			}
+
+			int overlap = 0;
+			for (uint32_t i = pc + 1; i < next; i++) {
+				overlap |= a->kind[i] != BYTE_DATA;
+			}
+			if (overlap) {
+				a->conflicts++;
+				break;
+			}
+
+			a->kind[pc] = BYTE_CODE;
+			for (uint32_t i = pc + 1; i < next; i++) {
+				a->kind[i] = BYTE_OPERAND;
+			}
+			a->code_bytes += info->length;
+			a->instructions++;
+
+			uint32_t target = 0;
+
+			// operand bytes only exist for 2- and 3-byte instructions; a 1-byte one
+			// can be the last byte of the image
+			if (info->length >= 2) {
+				target = code[1] | (info->length == 3 ? code[2] << 8 : 0);
+			}
+
+			int stop = 0;
+
+			switch (info->flow) {
+			case FLOW_JUMP:
+				reach(a, list, target, LABEL_JUMP);
+				stop = 1;
+				break;
+			case FLOW_JUMP_IF:
+				reach(a, list, target, LABEL_JUMP);
+				break;
+			case FLOW_CALL:
+			case FLOW_CALL_IF:
+				reach(a, list, target, LABEL_CALL);
+				break;
+			case FLOW_RST:
+				reach(a, list, code[0] & 0x38, LABEL_CALL | LABEL_VECTOR);
+				break;
+			case FLOW_RET:
+			case FLOW_INDIRECT:
+			case FLOW_HALT:
+				stop = 1;
+				break;
+			default:
+				break;
+			}
+
+			if (stop) {
+				break;
+			}
+
+			pc = next;
+		}
+	}
+}
+
+// Entries are followed one at a time, in order, so code reached from reset
+// claims its bytes before a speculative vector can misdecode them.
+void analysis_run(analysis* a, const uint32_t* entries, int entry_count) {
+
+	worklist list = { NULL, 0, 0 };
+
+	for (int i = 0; i < entry_count; i++) {
+		reach(a, &list, entries[i], LABEL_ENTRY);
+		drain(a, &list);
+	}
+
+	free(list.items);
+}
+
+void analysis_run_vectors(analysis* a) {
+
+	worklist list = { NULL, 0, 0 };
+
+	for (uint32_t vector = 0x08; vector <= 0x38 && vector < a->size; vector += 8) {
+
+		// Already decoded, either as a handler reached by RST or as part of
+		// the code around it; seeding it again would invent a label mid-run.
+		if (a->kind[vector] != BYTE_DATA) {
+			continue;
+		}
+
+		reach(a, &list, vector, LABEL_ENTRY | LABEL_VECTOR);
+		drain(a, &list);
+	}
+
+	free(list.items);
+}
+
+int analysis_label_name(const analysis* a, uint32_t address, char* out) {
+
+	if (address >= a->size || !a->label[address]) {
+		return 0;
+	}
+
+	uint8_t label = a->label[address];
+
+	if ((label & LABEL_ENTRY) && address == 0) {
+		return sprintf(out, "reset");
+	}
+	if (label & LABEL_VECTOR) {
+		return sprintf(out, "rst_%u", (unsigned)address / 8);
+	}
+	if (label & (LABEL_CALL | LABEL_ENTRY)) {
+		return sprintf(out, "sub_%04x", (unsigned)address);
+	}
+
+	return sprintf(out, "loc_%04x", (unsigned)address);
+}
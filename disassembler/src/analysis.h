@@ -0,0 +1,49 @@
+#ifndef _ANALYSIS_H
+#define _ANALYSIS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Recursive-traversal code discovery. Starting from the entry points (reset
+// and the RST vectors by default) every reachable instruction is decoded
+// once, following jumps, calls and conditional branches through a worklist.
+// Bytes that are never reached are data.
+
+// kind[] values
+#define BYTE_DATA       0
+#define BYTE_CODE       1       // first byte of an instruction
+#define BYTE_OPERAND    2       // operand byte of an instruction
+
+// label[] flags
+#define LABEL_ENTRY     0x01
+#define LABEL_JUMP      0x02
+#define LABEL_CALL      0x04
+#define LABEL_VECTOR    0x08    // an RST target or a seeded interrupt vector
+
+#define LABEL_NAME_MAX  16
+
+typedef struct {
+    const uint8_t* image;
+    size_t size;
+    uint8_t* kind;              // one BYTE_* per image byte
+    uint8_t* label;             // LABEL_* flags per image byte
+    size_t code_bytes;
+    int instructions;
+    int conflicts;              // branches into the middle of an instruction
+} analysis;
+
+void analysis_init(analysis* a, const uint8_t* image, size_t size);
+void analysis_free(analysis* a);
+
+void analysis_run(analysis* a, const uint32_t* entries, int entry_count);
+
+// Follows the RST 1-7 vectors as interrupt entry points, after the known
+// entries have run, skipping any vector whose byte is already code or an
+// operand.
+void analysis_run_vectors(analysis* a);
+
+// Writes the generated label for `address` ("reset", "rst_1", "sub_01e4",
+// "loc_01e4") into `out` and returns its length, or 0 if it has none.
+int analysis_label_name(const analysis* a, uint32_t address, char* out);
+
+#endif
@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "batch.h"
+
+#define BATCH_MAX_LINE  4096
+
+typedef struct {
+	char* line;             // the set's file specs, as listed
+	int line_number;        // in the list file
+	char* output;           // listing path, unique across the batch
+	size_t bytes;
+	bool failed;
+} batch_job;
+
+typedef struct {
+	const batch_options* options;
+	batch_job* jobs;
+	int job_count;
+	int next_job;           // claimed with an atomic add
+} batch_pool;
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// "roms/invaders/invaders.h" -> "<dir>/roms_invaders_invaders.h.lst"; a
+// nonzero `suffix` (the list line) gives "...invaders.h.<suffix>.lst".
+static char* output_path(const char* dir, const char* input, size_t length, int suffix) {
+
+	while (length >= 2 && input[0] == '.' && input[1] == '/') {
+		input += 2;
+		length -= 2;
+	}
+
+	char* out = malloc(strlen(dir) + length + 32);
+	int at = sprintf(out, "%s/", dir);
+
+	for (size_t i = 0; i < length; i++) {
+		out[at++] = (input[i] == '/') ? '_' : input[i];
+	}
+
+	if (suffix) {
+		sprintf(out + at, ".%d.lst", suffix);
+	} else {
+		sprintf(out + at, ".lst");
+	}
+
+	return out;
+}
+
+static int compare_outputs(const void* a, const void* b) {
+	const batch_job* x = *(batch_job* const*)a;
+	const batch_job* y = *(batch_job* const*)b;
+	int order = strcmp(x->output, y->output);
+
+	if (order) {
+		return order;
+	}
+	return (x->line_number > y->line_number) - (x->line_number < y->line_number);
+}
+
+// Length of the first file's path in a list line, without its @address.
+static size_t first_file_length(const char* line) {
+
+	size_t length = strcspn(line, " \t");
+
+	for (size_t at = length; at > 0; at--) {
+		if (line[at - 1] == '@') {
+			return at - 1;
+		}
+	}
+
+	return length;
+}
+
+// Names every job's listing after its first file. Sets that share a first
+// file would otherwise write the same listing, possibly from two threads at
+// once, so all but the first of them get their list line as a suffix; a
+// name that still clashes fails the later job.
+static void name_outputs(const char* dir, batch_job* jobs, int count) {
+
+	batch_job** sorted = malloc((count ? count : 1) * sizeof(batch_job*));
+
+	for (int i = 0; i < count; i++) {
+		jobs[i].output = output_path(dir, jobs[i].line, first_file_length(jobs[i].line), 0);
+		sorted[i] = &jobs[i];
+	}
+
+	qsort(sorted, count, sizeof(batch_job*), compare_outputs);
+
+	for (int i = 1, first = 0; i < count; i++) {
+		batch_job* job = sorted[i];
+
+		if (strcmp(job->output, sorted[first]->output) != 0) {
+			first = i;
+			continue;
+		}
+
+		free(job->output);
+		job->output = output_path(dir, job->line, first_file_length(job->line), job->line_number);
+	}
+
+	qsort(sorted, count, sizeof(batch_job*), compare_outputs);
+
+	for (int i = 1; i < count; i++) {
+		if (strcmp(sorted[i]->output, sorted[i - 1]->output) == 0) {
+			fprintf(stderr, "%s: line %d writes the same listing as line %d\n",
+				sorted[i]->output, sorted[i]->line_number, sorted[i - 1]->line_number);
+			sorted[i]->failed = true;
+		}
+	}
+
+	free(sorted);
+}
+
+static void run_job(batch_pool* pool, batch_job* job) {
+
+	const batch_options* options = pool->options;
+	rom_set set;
+
+	if (job->failed) {
+		return;
+	}
+
+	char* save = NULL;
+	char specs[BATCH_MAX_LINE];
+
+	// tokenise a copy so job->line is still whole for the failure report
+	snprintf(specs, sizeof(specs), "%s", job->line);
+	romset_init(&set);
+
+	for (char* spec = strtok_r(specs, " \t", &save); spec; spec = strtok_r(NULL, " \t", &save)) {
+		if (!romset_add(&set, spec)) {
+			job->failed = true;
+			romset_free(&set);
+			return;
+		}
+	}
+
+	if (!romset_load(&set)) {
+		job->failed = true;
+		romset_free(&set);
+		return;
+	}
+
+	FILE* out = fopen(job->output, "w");
+
+	if (!out) {
+		fprintf(stderr, "could not write %s\n", job->output);
+		job->failed = true;
+		romset_free(&set);
+		return;
+	}
+
+	listing_buffer listing;
+
+	listing_init(&listing, out, set.size);
+	listing.symbols = options->symbols;
+
+	options->worker(&listing, &set, options->context);
+
+	listing_free(&listing);
+	fclose(out);
+
+	job->bytes = set.size;
+	romset_free(&set);
+}
+
+static void* worker_main(void* argument) {
+
+	batch_pool* pool = argument;
+
+	for (;;) {
+		int index = __atomic_fetch_add(&pool->next_job, 1, __ATOMIC_RELAXED);
+
+		if (index >= pool->job_count) {
+			return NULL;
+		}
+
+		run_job(pool, &pool->jobs[index]);
+	}
+}
+
+static int read_jobs(const char* path, batch_job** jobs) {
+
+	FILE* list = fopen(path, "r");
+
+	if (!list) {
+		return -1;
+	}
+
+	char line[BATCH_MAX_LINE];
+	int line_number = 0;
+	int count = 0;
+	int capacity = 0;
+
+	*jobs = NULL;
+
+	while (fgets(line, sizeof(line), list)) {
+		line_number++;
+
+		char* start = line + strspn(line, " \t");
+
+		start[strcspn(start, "\r\n")] = '\0';
+
+		if (start[0] == '\0' || start[0] == '#') {
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			*jobs = realloc(*jobs, capacity * sizeof(batch_job));
+		}
+
+		(*jobs)[count].line = malloc(strlen(start) + 1);
+		strcpy((*jobs)[count].line, start);
+		(*jobs)[count].line_number = line_number;
+		(*jobs)[count].output = NULL;
+		(*jobs)[count].bytes = 0;
+		(*jobs)[count].failed = false;
+		count++;
+	}
+
+	fclose(list);
+
+	return count;
+}
+
+bool batch_run(const batch_options* options) {
+
+	batch_pool pool;
+
+	pool.options = options;
+	pool.next_job = 0;
+	pool.job_count = read_jobs(options->list_path, &pool.jobs);
+
+	if (pool.job_count < 0) {
+		fprintf(stderr, "could not read %s\n", options->list_path);
+		return false;
+	}
+
+	name_outputs(options->out_dir, pool.jobs, pool.job_count);
+
+	int threads = options->threads;
+
+	if (threads <= 0) {
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads > pool.job_count) {
+		threads = pool.job_count;
+	}
+	if (threads > BATCH_MAX_THREADS) {
+		threads = BATCH_MAX_THREADS;
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	pthread_t workers[BATCH_MAX_THREADS];
+	uint64_t start_ns = now_ns();
+
+	for (int i = 1; i < threads; i++) {
+		pthread_create(&workers[i], NULL, worker_main, &pool);
+	}
+
+	// the calling thread is worker 0
+	worker_main(&pool);
+
+	for (int i = 1; i < threads; i++) {
+		pthread_join(workers[i], NULL);
+	}
+
+	double seconds = (now_ns() - start_ns) / 1e9;
+	size_t total_bytes = 0;
+	int failed = 0;
+
+	for (int i = 0; i < pool.job_count; i++) {
+		total_bytes += pool.jobs[i].bytes;
+
+		if (pool.jobs[i].failed) {
+			fprintf(stderr, "failed: %s\n", pool.jobs[i].line);
+			failed++;
+		}
+
+		free(pool.jobs[i].line);
+		free(pool.jobs[i].output);
+	}
+
+	free(pool.jobs);
+
+	printf("%d images, %zu bytes in %.3f s on %d threads (%.1f MB/s)",
+		pool.job_count - failed, total_bytes, seconds, threads,
+		seconds > 0 ? total_bytes / seconds / 1e6 : 0.0);
+	if (failed) {
+		printf(", %d failed\n", failed);
+	} else {
+		printf("\n");
+	}
+
+	return failed == 0;
+}
@@ -0,0 +1,37 @@
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <stdbool.h>
+
+#include "listing.h"
+#include "romset.h"
+
+// Batch disassembly of a library of ROM sets on a pool of worker threads.
+//
+// The list file has one ROM set per line, given the same way as on the
+// command line ("file[@address] ..."); blank lines and lines starting with
+// '#' are skipped. Each set is written to its own listing file in the output
+// directory, named after the path of its first file with '/' turned into
+// '_' plus ".lst"; when several sets start with the same file, all but the
+// first also get their list line number (".<line>.lst"). Workers share nothing but the job counter, so each one
+// loads its set, owns its listing buffer and writes its own file.
+
+#define BATCH_MAX_THREADS   64
+
+// Disassembles one loaded set into `listing`; `context` is passed through.
+typedef void (*batch_worker)(listing_buffer* listing, const rom_set* set, const void* context);
+
+typedef struct {
+    const char* list_path;
+    const char* out_dir;
+    int threads;                    // 0: one per online CPU
+    const symbol_table* symbols;    // shared, read-only
+    batch_worker worker;
+    const void* context;
+} batch_options;
+
+// Runs every job in the list and prints a throughput summary. Returns false
+// if the list could not be read or any job failed.
+bool batch_run(const batch_options* options);
+
+#endif
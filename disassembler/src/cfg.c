@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "../../common/opcodes.h"
+
+static void add_edge(block_graph* graph, uint32_t* capacity, uint32_t target, uint8_t kind) {
+
+	if (graph->edge_count == *capacity) {
+		*capacity = *capacity ? *capacity * 2 : 256;
+		graph->edges = realloc(graph->edges, *capacity * sizeof(block_edge));
+	}
+
+	graph->edges[graph->edge_count].target = target;
+	graph->edges[graph->edge_count].kind = kind;
+	graph->edge_count++;
+}
+
+void cfg_build(block_graph* graph, const analysis* a) {
+
+	uint32_t block_capacity = 0;
+	uint32_t edge_capacity = 0;
+	uint8_t* leader = calloc(a->size ? a->size : 1, 1);
+
+	memset(graph, 0, sizeof(*graph));
+
+	// branch targets and whatever follows a control transfer start blocks
+	for (uint32_t pc = 0; pc < a->size; pc++) {
+		if (a->kind[pc] != BYTE_CODE) {
+			continue;
+		}
+		if (a->label[pc]) {
+			leader[pc] = 1;
+		}
+
+		uint32_t next = pc + opcode_table[a->image[pc]].length;
+		if (opcode_table[a->image[pc]].flow != FLOW_NEXT && next < a->size) {
+			leader[next] = 1;
+		}
+	}
+
+	uint32_t pc = 0;
+
+	while (pc < a->size) {
+		if (a->kind[pc] != BYTE_CODE) {
+			pc++;
+			continue;
+		}
+
+		if (graph->block_count == block_capacity) {
+			block_capacity = block_capacity ? block_capacity * 2 : 256;
+			graph->blocks = realloc(graph->blocks, block_capacity * sizeof(basic_block));
+		}
+
+		basic_block* block = &graph->blocks[graph->block_count++];
+		const opcode_info* info;
+		const uint8_t* code;
+		uint32_t next;
+
+		memset(block, 0, sizeof(*block));
+		block->start = pc;
+		block->first_edge = graph->edge_count;
+
+		for (;;) {
+			code = a->image + pc;
+			info = &opcode_table[code[0]];
+			next = pc + info->length;
+
+			block->instructions++;
+			block->cycles += info->cycles;
+
+			if (info->flow != FLOW_NEXT || next >= a->size || a->kind[next] != BYTE_CODE || leader[next]) {
+				break;
+			}
+
+			pc = next;
+		}
+
+		block->end = next;
+		block->taken_cycles = block->cycles - info->cycles + info->taken_cycles;
+
+		uint32_t target = 0;
+
+		// operand bytes only exist for 2- and 3-byte instructions; a 1-byte one
+		// can be the last byte of the image
+		if (info->length >= 2) {
+			target = code[1] | (info->length == 3 ? code[2] << 8 : 0);
+		}
+
+		int falls_through = 1;
+
+		switch (info->flow) {
+		case FLOW_JUMP:
+			add_edge(graph, &edge_capacity, target, EDGE_JUMP);
+			falls_through = 0;
+			break;
+		case FLOW_JUMP_IF:
+			add_edge(graph, &edge_capacity, target, EDGE_BRANCH);
+			break;
+		case FLOW_CALL:
+		case FLOW_CALL_IF:
+			add_edge(graph, &edge_capacity, target, EDGE_CALL);
+			break;
+		case FLOW_RST:
+			add_edge(graph, &edge_capacity, code[0] & 0x38, EDGE_CALL);
+			break;
+		case FLOW_RET:
+		case FLOW_INDIRECT:
+		case FLOW_HALT:
+			falls_through = 0;
+			break;
+		default:
+			break;
+		}
+
+		if (falls_through && next < a->size && a->kind[next] == BYTE_CODE) {
+			add_edge(graph, &edge_capacity, next, EDGE_FALLTHROUGH);
+		}
+
+		block->edge_count = graph->edge_count - block->first_edge;
+		pc = next;
+	}
+
+	free(leader);
+}
+
+static const char* block_name(const analysis* a, const symbol_table* symbols, uint32_t address, char* generated) {
+
+	const char* name = symbols_lookup(symbols, address);
+
+	if (!name && analysis_label_name(a, address, generated)) {
+		name = generated;
+	}
+
+	return name;
+}
+
+void cfg_free(block_graph* graph) {
+	free(graph->blocks);
+	free(graph->edges);
+	memset(graph, 0, sizeof(*graph));
+}
+
+void cfg_write_dot(FILE* out, const block_graph* graph, const analysis* a, const symbol_table* symbols) {
+
+	static const char* edge_styles[] = {
+		[EDGE_FALLTHROUGH] = "",
+		[EDGE_JUMP] = " [style=bold]",
+		[EDGE_BRANCH] = " [color=darkgreen]",
+		[EDGE_CALL] = " [style=dashed]",
+	};
+
+	fprintf(out, "digraph cfg {\n\tnode [shape=box, fontname=monospace];\n");
+
+	for (uint32_t i = 0; i < graph->block_count; i++) {
+		const basic_block* block = &graph->blocks[i];
+		char generated[LABEL_NAME_MAX];
+		const char* name = block_name(a, symbols, block->start, generated);
+
+		fprintf(out, "\tb%04x [label=\"%s%s%04x-%04x\\n%u instr, %u", block->start,
+			name ? name : "", name ? "\\n" : "", block->start, block->end - 1,
+			block->instructions, block->cycles);
+
+		if (block->taken_cycles != block->cycles) {
+			fprintf(out, "/%u", block->taken_cycles);
+		}
+
+		fprintf(out, " cycles\"];\n");
+
+		for (uint32_t e = block->first_edge; e < block->first_edge + block->edge_count; e++) {
+			fprintf(out, "\tb%04x -> b%04x%s;\n", block->start, graph->edges[e].target,
+				edge_styles[graph->edges[e].kind]);
+		}
+	}
+
+	fprintf(out, "}\n");
+}
@@ -0,0 +1,56 @@
+#ifndef _CFG_H
+#define _CFG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "analysis.h"
+#include "../../common/symbols.h"
+
+// Basic-block control-flow graph over the code found by the recursive
+// analysis. A block is a straight run of instructions entered only at its
+// first instruction and left only after its last one; its cycle counts come
+// from the opcode table.
+
+typedef enum {
+    EDGE_FALLTHROUGH,           // into the next block (also where a call returns)
+    EDGE_JUMP,                  // JMP
+    EDGE_BRANCH,                // a conditional jump taken
+    EDGE_CALL,                  // CALL, Ccc or RST target
+} edge_kind;
+
+typedef struct {
+    uint32_t target;
+    uint8_t kind;
+} block_edge;
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint32_t instructions;
+    uint32_t cycles;            // every branch in the block falls through
+    uint32_t taken_cycles;      // the final conditional CALL / RET is taken
+    uint32_t first_edge;
+    uint32_t edge_count;
+} basic_block;
+
+// Blocks are sorted by start address; each block's edges are contiguous.
+typedef struct {
+    basic_block* blocks;
+    uint32_t block_count;
+    block_edge* edges;
+    uint32_t edge_count;
+} block_graph;
+
+// Splits the code found by the analysis into basic blocks. A block ends at
+// any instruction that can transfer control (calls included) and before any
+// branch target.
+void cfg_build(block_graph* graph, const analysis* a);
+void cfg_free(block_graph* graph);
+
+// Graphviz DOT: one node per block (name, address range, instructions,
+// cycles), solid edges for fall-through, bold for jumps, green for taken
+// branches and dashed for calls.
+void cfg_write_dot(FILE* out, const block_graph* graph, const analysis* a, const symbol_table* symbols);
+
+#endif
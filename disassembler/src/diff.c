@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "diff.h"
+#include "../../common/opcodes.h"
+
+size_t diff_next(const uint8_t* a, const uint8_t* b, size_t start, size_t size) {
+
+	size_t i = start;
+
+#if defined(__AVX2__)
+	for (; i + 32 <= size; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+		uint32_t equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+
+		if (equal != 0xFFFFFFFFu) {
+			return i + __builtin_ctz(~equal);
+		}
+	}
+#endif
+
+#if defined(__SSE2__)
+	for (; i + 16 <= size; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+		uint32_t equal = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+
+		if (equal != 0xFFFF) {
+			return i + __builtin_ctz(~equal);
+		}
+	}
+#else
+	for (; i + 8 <= size; i += 8) {
+		uint64_t wa, wb;
+
+		memcpy(&wa, a + i, 8);
+		memcpy(&wb, b + i, 8);
+
+		if (wa != wb) {
+			break;
+		}
+	}
+#endif
+
+	for (; i < size; i++) {
+		if (a[i] != b[i]) {
+			return i;
+		}
+	}
+
+	return size;
+}
+
+// End of the region starting at `start`: the first run of DIFF_MERGE_GAP
+// equal bytes, or the end of the common length.
+static size_t region_end(const uint8_t* a, const uint8_t* b, size_t start, size_t size) {
+
+	size_t end = start + 1;
+
+	for (;;) {
+		size_t next = diff_next(a, b, end, size);
+
+		if (next - end >= DIFF_MERGE_GAP || next == size) {
+			return end;
+		}
+
+		end = next + 1;
+	}
+}
+
+// One column: "addr  instruction", padded; blank once the side is done.
+static void put_column(FILE* out, const uint8_t* image, size_t size, uint32_t pc, int active,
+	const symbol_table* symbols, int pad) {
+
+	char text[OPCODE_TEXT_MAX];
+	char column[DIFF_COLUMN_WIDTH + OPCODE_TEXT_MAX];
+
+	column[0] = '\0';
+
+	if (active && pc < size) {
+		const opcode_info* info = &opcode_table[image[pc]];
+		uint8_t code[3] = { image[pc], 0, 0 };
+
+		if (pc + info->length > size) {
+			sprintf(text, "DB     %02x", image[pc]);
+		} else {
+			memcpy(code, image + pc, info->length);
+
+			const char* name = NULL;
+
+			if (info->operand == OPERAND_WORD || info->operand == OPERAND_ADDRESS) {
+				name = symbols_lookup(symbols, code[1] | code[2] << 8);
+			}
+
+			opcode_format(code, name, text);
+		}
+
+		sprintf(column, "%04x  %s", (unsigned)pc, text);
+	}
+
+	if (pad) {
+		fprintf(out, "%-*s", DIFF_COLUMN_WIDTH, column);
+	} else {
+		fprintf(out, "%.*s", DIFF_COLUMN_WIDTH, column);
+	}
+}
+
+static uint32_t step(const uint8_t* image, size_t size, uint32_t pc) {
+	int length = opcode_table[image[pc]].length;
+	return pc + length <= size ? pc + length : pc + 1;
+}
+
+diff_summary diff_report(FILE* out, const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size,
+	const symbol_table* symbols) {
+
+	diff_summary summary = { 0, 0 };
+	size_t size = a_size < b_size ? a_size : b_size;
+	size_t synced = 0;      // a known instruction boundary in a's linear decode
+	size_t start = diff_next(a, b, 0, size);
+
+	while (start < size) {
+		size_t end = region_end(a, b, start, size);
+
+		summary.regions++;
+
+		// The bytes before the region are the same on both sides, so one
+		// walk from the last known boundary finds the instruction the region
+		// starts in. synced only moves forward, so all the walks together
+		// cover the image once.
+		uint32_t pc = synced;
+
+		while (step(a, size, pc) <= start) {
+			pc = step(a, size, pc);
+		}
+
+		fprintf(out, "\n; %04x-%04x differs\n", (unsigned)start, (unsigned)(end - 1));
+
+		uint32_t pa = pc;
+		uint32_t pb = pc;
+
+		// list both sides past the region, then until they meet again
+		while (pa < end || pb < end || pa != pb) {
+			int left = pa < end || pa < pb;
+			int right = pb < end || pb < pa;
+
+			// decodes that never meet are cut off once well past the region
+			if ((pa >= size && pb >= size) || (pa >= end + DIFF_RESYNC_LIMIT && pb >= end + DIFF_RESYNC_LIMIT)) {
+				break;
+			}
+
+			put_column(out, a, size, pa, left, symbols, 1);
+			fprintf(out, " | ");
+			put_column(out, b, size, pb, right, symbols, 0);
+			fprintf(out, "\n");
+
+			if (left) {
+				pa = step(a, size, pa);
+			}
+			if (right) {
+				pb = step(b, size, pb);
+			}
+		}
+
+		// The sides meet again at a shared boundary. If they were cut off
+		// instead, pa is still a boundary in a's decode; either way it is at
+		// or past the region's end.
+		size_t listed = pa > pb ? pa : pb;
+
+		synced = pa < size ? pa : size;
+		if (listed > size) {
+			listed = size;
+		}
+
+		// anything the resync walked over was listed as part of this region
+		for (size_t i = start; i < listed; i++) {
+			summary.bytes += a[i] != b[i];
+		}
+
+		start = diff_next(a, b, listed, size);
+	}
+
+	if (a_size != b_size) {
+		fprintf(out, "\n; sizes differ: %zu and %zu bytes; only the first %zu compared\n", a_size, b_size, size);
+	}
+
+	fprintf(out, "\n; %u differing regions, %zu bytes\n", summary.regions, summary.bytes);
+
+	return summary;
+}
@@ -0,0 +1,33 @@
+#ifndef _DIFF_H
+#define _DIFF_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../../common/symbols.h"
+
+// Instruction-aligned diff of two images, such as two ROM builds or two
+// memory snapshots. Equal stretches are skipped with a vectorised compare;
+// each differing region is widened to whole instructions on both sides and
+// listed side by side until the two decodes line up again. Differences
+// closer together than DIFF_MERGE_GAP equal bytes are shown as one region.
+
+#define DIFF_MERGE_GAP      8
+#define DIFF_RESYNC_LIMIT   32      // bytes listed past a region before giving up on a resync
+#define DIFF_COLUMN_WIDTH   40
+
+typedef struct {
+    unsigned regions;
+    size_t bytes;           // differing bytes within the common length
+} diff_summary;
+
+// Offset of the first byte from `start` on where `a` and `b` differ, or
+// `size` if there is none.
+size_t diff_next(const uint8_t* a, const uint8_t* b, size_t start, size_t size);
+
+// Lists every differing region of the two images to `out`.
+diff_summary diff_report(FILE* out, const uint8_t* a, size_t a_size, const uint8_t* b, size_t b_size,
+	const symbol_table* symbols);
+
+#endif
@@ -3,842 +3,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "analysis.h"
+#include "listing.h"
+#include "xref.h"
+#include "cfg.h"
+#include "romset.h"
+#include "batch.h"
+#include "stream.h"
+#include "diff.h"
+
 #define MAX_INTRO_LINES 14
 #define MAX_INTRO_CHARS 50
-
-static int file_size;
-
-uint8_t disassemble(uint8_t* code_buffer, int pc) {
-
-	uint8_t op_bytes = 1;
-	//TODO - rename "code" to "operation"
-	uint8_t* code = code_buffer + pc;
-
-	printf("%04x  ", pc);
-
-	switch(*code) {
-	case 0x00:
-		printf("NOP\n");
-		break;
-	case 0x01:
-		printf("LXI    B, %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x02:
-		printf("STAX   B\n");
-		break;
-	case 0x03:
-		printf("INX    B\n");
-		break;
-	case 0x04:
-		printf("INR    B\n");
-		break;
-	case 0x05:
-		printf("DCR    B\n");
-		break;
-	case 0x06:
-		printf("MVI    B, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x07:
-		printf("RLC\n");
-		break;
-	case 0x08:
-		printf("NOP\n");
-		break;
-	case 0x09:
-		printf("DAD    B\n");
-		break;
-	case 0xA:
-		printf("LDAX   B\n");
-		break;
-	case 0xB:
-		printf("DCX    B\n");
-		break;
-	case 0xC:
-		printf("INR    C\n");
-		break;
-	case 0xD:
-		printf("DCR    C\n");
-		break;
-	case 0xE:
-		printf("MVI     C, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xF:
-		printf("RRC\n");
-		break;
-	case 0x10:
-		printf("NOP\n");
-		break;
-	case 0x11:
-		printf("LXI     D, %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x12:
-		printf("STAX    D\n");
-		break;
-	case 0x13:
-		printf("INX     D\n");
-		break;
-	case 0x14:
-		printf("INR     D\n");
-		break;
-	case 0x15:
-		printf("DCR     D\n");
-		break;
-	case 0x16:
-		printf("MVI     D, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x17:
-		printf("RAL\n");
-		break;
-	case 0x18:
-		printf("NOP\n");
-		break;
-	case 0x19:
-		printf("DAD    D\n");
-		break;
-	case 0x1A:
-		printf("LDAX   D\n");
-		break;
-	case 0x1B:
-		printf("DCX    D\n");
-		break;
-	case 0x1C:
-		printf("INR    E\n");
-		break;
-	case 0x1D:
-		printf("DCR    E\n");
-		break;
-	case 0x1E:
-		printf("MVI    E, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x1F:
-		printf("RAR\n");
-		break;
-	case 0x20:
-		printf("NOP\n");
-		break;
-	case 0x21:
-		printf("LXI    H, %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x22:
-		printf("SHLD      %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x23:
-		printf("INX    H\n");
-		break;
-	case 0x24:
-		printf("INR    H\n");
-		break;
-	case 0x25:
-		printf("DCR    H\n");
-		break;
-	case 0x26:
-		printf("MVI    H, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x27:
-		printf("DAA\n");
-		break;
-	case 0x28:
-		printf("NOP\n");
-		break;
-	case 0x29:
-		printf("DAD    H\n");
-		break;
-	case 0x2A:
-		printf("LHLD   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x2B:
-		printf("DCX    H\n");
-		break;
-	case 0x2C:
-		printf("INR    L\n");
-		break;
-	case 0x2D:
-		printf("DCR    L\n");
-		break;
-	case 0x2E:
-		printf("MVI    L, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x2F:
-		printf("CMA\n");
-		break;
-	case 0x30:
-		printf("NOP\n");
-		break;
-	case 0x31:
-		printf("LXI    SP, %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x32:
-		printf("STA    %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x33:
-		printf("INX    SP\n");
-		break;
-	case 0x34:
-		printf("INR    M\n");
-		break;
-	case 0x35:
-		printf("DCR    M\n");
-		break;
-	case 0x36:
-		printf("MVI    M, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x37:
-		printf("STC\n");
-		break;
-	case 0x38:
-		printf("NOP\n");
-		break;
-	case 0x39:
-		printf("DAD   SP\n");
-		break;
-	case 0x3A:
-		printf("LDA   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0x3B:
-		printf("DCX   SP\n");
-		break;
-	case 0x3C:
-		printf("INR   A\n");
-		break;
-	case 0x3D:
-		printf("DCR   A\n");
-		break;
-	case 0x3E:
-		printf("MVI   A, %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0x3F:
-		printf("CMC\n");
-		break;
-	case 0x40:
-		printf("MOV   B, B\n");
-		break;
-	case 0x41:
-		printf("MOV   B, C\n");
-		break;
-	case 0x42:
-		printf("MOV   B, D\n");
-		break;
-	case 0x43:
-		printf("MOV   B, E\n");
-		break;
-	case 0x44:
-		printf("MOV   B, H\n");
-		break;
-	case 0x45:
-		printf("MOV   B, L\n");
-		break;
-	case 0x46:
-		printf("MOV   B, M\n");
-		break;
-	case 0x47:
-		printf("MOV   B, A\n");
-		break;
-	case 0x48:
-		printf("MOV   C, B\n");
-		break;
-	case 0x49:
-		printf("MOV   C, C\n");
-		break;
-	case 0x4A:
-		printf("MOV   C, D\n");
-		break;
-	case 0x4B:
-		printf("MOV   C, E\n");
-		break;
-	case 0x4C:
-		printf("MOV   C, H\n");
-		break;
-	case 0x4D:
-		printf("MOV   C, L\n");
-		break;
-	case 0x4E:
-		printf("MOV   C, M\n");
-		break;
-	case 0x4F:
-		printf("MOV   C, A\n");
-		break;
-	case 0x50:
-		printf("MOV   D, B\n");
-		break;
-	case 0x51:
-		printf("MOV   D, C\n");
-		break;
-	case 0x52:
-		printf("MOV   D, D\n");
-		break;
-	case 0x53:
-		printf("MOV   D, E\n");
-		break;
-	case 0x54:
-		printf("MOV   D, H\n");
-		break;
-	case 0x55:
-		printf("MOV   D, L\n");
-		break;
-	case 0x56:
-		printf("MOV   D, M\n");
-		break;
-	case 0x57:
-		printf("MOV   D, A\n");
-		break;
-	case 0x58:
-		printf("MOV   E, B\n");
-		break;
-	case 0x59:
-		printf("MOV   E, C\n");
-		break;
-	case 0x5A:
-		printf("MOV   E, D\n");
-		break;
-	case 0x5B:
-		printf("MOV   E, E\n");
-		break;
-	case 0x5C:
-		printf("MOV   E, H\n");
-		break;
-	case 0x5D:
-		printf("MOV   E, L\n");
-		break;
-	case 0x5E:
-		printf("MOV   E, M\n");
-		break;
-	case 0x5F:
-		printf("MOV   E, A\n");
-		break;
-	case 0x60:
-		printf("MOV   H, B\n");
-		break;
-	case 0x61:
-		printf("MOV   H, C\n");
-		break;
-	case 0x62:
-		printf("MOV   H, D\n");
-		break;
-	case 0x63:
-		printf("MOV   H, E\n");
-		break;
-	case 0x64:
-		printf("MOV   H, H\n");
-		break;
-	case 0x65:
-		printf("MOV   H, L\n");
-		break;
-	case 0x66:
-		printf("MOV   H, M\n");
-		break;
-	case 0x67:
-		printf("MOV   H, A\n");
-		break;
-	case 0x68:
-		printf("MOV   L, B\n");
-		break;
-	case 0x69:
-		printf("MOV   L, C\n");
-		break;
-	case 0x6A:
-		printf("MOV   L, D\n");
-		break;
-	case 0x6B:
-		printf("MOV   L, E\n");
-		break;
-	case 0x6C:
-		printf("MOV   L, H\n");
-		break;
-	case 0x6D:
-		printf("MOV   L, L\n");
-		break;
-	case 0x6E:
-		printf("MOV   L, M\n");
-		break;
-	case 0x6F:
-		printf("MOV   L, A\n");
-		break;
-	case 0x70:
-		printf("MOV   M, B\n");
-		break;
-	case 0x71:
-		printf("MOV   M, C\n");
-		break;
-	case 0x72:
-		printf("MOV   M, D\n");
-		break;
-	case 0x73:
-		printf("MOV   M, E\n");
-		break;
-	case 0x74:
-		printf("MOV   M, H\n");
-		break;
-	case 0x75:
-		printf("MOV   M, L\n");
-		break;
-	case 0x76:
-		printf("MOV   M, M\n");
-		break;
-	case 0x77:
-		printf("MOV   M, A\n");
-		break;
-	case 0x78:
-		printf("MOV   A, B\n");
-		break;
-	case 0x79:
-		printf("MOV   A, C\n");
-		break;
-	case 0x7A:
-		printf("MOV   A, D\n");
-		break;
-	case 0x7B:
-		printf("MOV   A, E\n");
-		break;
-	case 0x7C:
-		printf("MOV   A, H\n");
-		break;
-	case 0x7D:
-		printf("MOV   A, L\n");
-		break;
-	case 0x7E:
-		printf("MOV   A, M\n");
-		break;
-	case 0x7F:
-		printf("MOV   A, A\n");
-		break;
-	case 0x80:
-		printf("ADD   B\n");
-		break;
-	case 0x81:
-		printf("ADD   C\n");
-		break;
-	case 0x82:
-		printf("ADD   D\n");
-		break;
-	case 0x83:
-		printf("ADD   E\n");
-		break;
-	case 0x84:
-		printf("ADD   H\n");
-		break;
-	case 0x85:
-		printf("ADD   L\n");
-		break;
-	case 0x86:
-		printf("ADD   M\n");
-		break;
-	case 0x87:
-		printf("ADD   A\n");
-		break;
-	case 0x88:
-		printf("ADC   B\n");
-		break;
-	case 0x89:
-		printf("ADC   C\n");
-		break;
-	case 0x8A:
-		printf("ADC   D\n");
-		break;
-	case 0x8B:
-		printf("ADC   E\n");
-		break;
-	case 0x8C:
-		printf("ADC   H\n");
-		break;
-	case 0x8D:
-		printf("ADC   L\n");
-		break;
-	case 0x8E:
-		printf("ADC   M\n");
-		break;
-	case 0x8F:
-		printf("ADC   A\n");
-		break;
-	case 0x90:
-		printf("SUB   B\n");
-		break;
-	case 0x91:
-		printf("SUB   C\n");
-		break;
-	case 0x92:
-		printf("SUB   D\n");
-		break;
-	case 0x93:
-		printf("SUB   E\n");
-		break;
-	case 0x94:
-		printf("SUB   H\n");
-		break;
-	case 0x95:
-		printf("SUB   L\n");
-		break;
-	case 0x96:
-		printf("SUB   M\n");
-		break;
-	case 0x97:
-		printf("SUB   A\n");
-		break;
-	case 0x98:
-		printf("SBB   B\n");
-		break;
-	case 0x99:
-		printf("SBB   C\n");
-		break;
-	case 0x9A:
-		printf("SBB   D\n");
-		break;
-	case 0x9B:
-		printf("SBB   E\n");
-		break;
-	case 0x9C:
-		printf("SBB   H\n");
-		break;
-	case 0x9D:
-		printf("SBB   L\n");
-		break;
-	case 0x9E:
-		printf("SBB   M\n");
-		break;
-	case 0x9F:
-		printf("SBB   A\n");
-		break;
-	case 0xA0:
-		printf("ANA   B\n");
-		break;
-	case 0xA1:
-		printf("ANA   C\n");
-		break;
-	case 0xA2:
-		printf("ANA   D\n");
-		break;
-	case 0xA3:
-		printf("ANA   E\n");
-		break;
-	case 0xA4:
-		printf("ANA   H\n");
-		break;
-	case 0xA5:
-		printf("ANA   L\n");
-		break;
-	case 0xA6:
-		printf("ANA   M\n");
-		break;
-	case 0xA7:
-		printf("ANA   A\n");
-		break;
-	case 0xA8:
-		printf("XRA   B\n");
-		break;
-	case 0xA9:
-		printf("XRA   C\n");
-		break;
-	case 0xAA:
-		printf("XRA   D\n");
-		break;
-	case 0xAB:
-		printf("XRA   E\n");
-		break;
-	case 0xAC:
-		printf("XRA   H\n");
-		break;
-	case 0xAD:
-		printf("XRA   L\n");
-		break;
-	case 0xAE:
-		printf("XRA   M\n");
-		break;
-	case 0xAF:
-		printf("XRA   A\n");
-		break;
-	case 0xB0:
-		printf("ORA   B\n");
-		break;
-	case 0xB1:
-		printf("ORA   C\n");
-		break;
-	case 0xB2:
-		printf("ORA   D\n");
-		break;
-	case 0xB3:
-		printf("ORA   E\n");
-		break;
-	case 0xB4:
-		printf("ORA   H\n");
-		break;
-	case 0xB5:
-		printf("ORA   L\n");
-		break;
-	case 0xB6:
-		printf("ORA   M\n");
-		break;
-	case 0xB7:
-		printf("ORA   A\n");
-		break;
-	case 0xB8:
-		printf("CMP   B\n");
-		break;
-	case 0xB9:
-		printf("CMP   C\n");
-		break;
-	case 0xBA:
-		printf("CMP   D\n");
-		break;
-	case 0xBB:
-		printf("CMP   E\n");
-		break;
-	case 0xBC:
-		printf("CMP   H\n");
-		break;
-	case 0xBD:
-		printf("CMP   L\n");
-		break;
-	case 0xBE:
-		printf("CMP   M\n");
-		break;
-	case 0xBF:
-		printf("CMP   A\n");
-		break;
-	case 0xC0:
-		printf("RNZ\n");
-		break;
-	case 0xC1:
-		printf("POP   B\n");
-		break;
-	case 0xC2:
-		printf("JNZ   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xC3:
-		printf("JMP   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xC4:
-		printf("CNZ   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xC5:
-		printf("PUSH   B\n");
-		break;
-	case 0xC6:
-		printf("ADI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xC7:
-		printf("RST   0\n");
-		break;
-	case 0xC8:
-		printf("RZ\n");
-		break;
-	case 0xC9:
-		printf("RET\n");
-		break;
-	case 0xCA:
-		printf("JZ   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xCB:
-		printf("JMP   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xCC:
-		printf("CZ   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xCD:
-		printf("CALL   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xCE:
-		printf("ACI   %02x\n", code[1]);
-		op_bytes = 2;
-	case 0xCF:
-		printf("RST   1\n");
-		break;
-	case 0xD0:
-		printf("RNC\n");
-		break;
-	case 0xD1:
-		printf("POP   D\n");
-		break;
-	case 0xD2:
-		printf("JNC   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xD3:
-		printf("OUT   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xD4:
-		printf("CNC   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xD5:
-		printf("PUSH   D\n");
-		break;
-	case 0xD6:
-		printf("SUI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xD7:
-		printf("RST   2\n");
-		break;
-	case 0xD8:
-		printf("RC\n");
-		break;
-	case 0xD9:
-		printf("RET\n");
-		break;
-	case 0xDA:
-		printf("JC   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xDB:
-		printf("IN   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xDC:
-		printf("CC   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xDD:
-		printf("CALL   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xDE:
-		printf("SBI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xDF:
-		printf("RST   3\n");
-		break;
-	case 0xE0:
-		printf("RPO\n");
-		break;
-	case 0xE1:
-		printf("POP   H\n");
-		break;
-	case 0xE2:
-		printf("JPO   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xE3:
-		printf("XTHL\n");
-		break;
-	case 0xE4:
-		printf("CPO   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xE5:
-		printf("PUSH   H\n");
-		break;
-	case 0xE6:
-		printf("ANI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xE7:
-		printf("RST   4\n");
-		break;
-	case 0xE8:
-		printf("RPE\n");
-		break;
-	case 0xE9:
-		printf("PCHL\n");
-		break;
-	case 0xEA:
-		printf("JPE   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xEB:
-		printf("XCHG\n");
-		break;
-	case 0xEC:
-		printf("CPE   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xED:
-		printf("CALL   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xEE:
-		printf("XRI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xEF:
-		printf("RST   5\n");
-		break;
-	case 0xF0:
-		printf("RP\n");
-		break;
-	case 0xF1:
-		printf("POP   PSW\n");
-		break;
-	case 0xF2:
-		printf("JP   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xF3:
-		printf("DI\n");
-		break;
-	case 0xF4:
-		printf("CP   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xF5:
-		printf("PUSH   PSW\n");
-		break;
-	case 0xF6:
-		printf("ORI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xF7:
-		printf("RST   6\n");
-		break;
-	case 0xF8:
-		printf("RM\n");
-		break;
-	case 0xF9:
-		printf("SPHL\n");
-		break;
-	case 0xFA:
-		printf("JM   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xFB:
-		printf("EI\n");
-		break;
-	case 0xFC:
-		printf("CM   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xFD:
-		printf("CALL   %02x%02x\n", code[2], code[1]);
-		op_bytes = 3;
-		break;
-	case 0xFE:
-		printf("CPI   %02x\n", code[1]);
-		op_bytes = 2;
-		break;
-	case 0xFF:
-		printf("RST   7\n");
-		break;
-	default:
-		printf("Unhandled Instruction....\n");
-		break;
-	}
-
-	return op_bytes;
-}
+#define MAX_ENTRIES 64
 
 void display_intro() {
 
@@ -859,33 +35,153 @@ void display_intro() {
 		for(int i = 0; i < intro_array_count; i++) {
 			printf("%s", intro_array[i]);
 		}
+
+		fclose(intro_file);
 	}
+}
+
+typedef struct {
+	int verbose;
+	int recursive;
+	int xrefs;
+	const char* dot_path;           // -g: block graph as Graphviz DOT
+	uint32_t entries[MAX_ENTRIES];  // -e: extra entry points
+	int entry_count;
+} disasm_options;
+
+// Linear sweep: decode every byte as code from offset 0.
+static void list_linear(listing_buffer* listing, const uint8_t* rom_buffer, size_t file_size, const disasm_options* options) {
+
+	unsigned int pc = 0;
+
+	while(pc < file_size) {
 
-	fclose(intro_file);
+		if(listing_has_label(listing, NULL, pc)) {
+			listing_label(listing, NULL, pc);
+		}
+
+		pc += listing_instruction(listing, rom_buffer, file_size, pc, NULL);
+	}
+
+	if(options->xrefs) {
+		xref_index index;
+
+		xref_build(&index, rom_buffer, file_size, NULL);
+		listing_flush(listing);
+		xref_report(listing->file, &index, listing->symbols, NULL);
+		xref_free(&index);
+	}
 }
 
-uint8_t* open_rom(char* fileName) {
+static void export_blocks(const analysis* a, const symbol_table* symbols, const disasm_options* options) {
+
+	block_graph graph;
+
+	cfg_build(&graph, a);
+
+	if(options->dot_path) {
+		FILE* dot = fopen(options->dot_path, "w");
+
+		if(dot) {
+			cfg_write_dot(dot, &graph, a, symbols);
+			fclose(dot);
+		} else {
+			fprintf(stderr, "could not write %s\n", options->dot_path);
+		}
+	}
+
+	if(options->verbose) {
+		fprintf(stderr, "%u basic blocks, %u edges\n", graph.block_count, graph.edge_count);
+	}
+
+	cfg_free(&graph);
+}
+
+// Recursive traversal: only reachable bytes are listed as code, with labels;
+// everything else is listed as DB rows.
+static void list_recursive(listing_buffer* listing, const uint8_t* rom_buffer, size_t file_size, const disasm_options* options) {
+
+	analysis a;
+	unsigned int pc = 0;
+
+	uint32_t all_entries[MAX_ENTRIES + 1] = { 0 };
+
+	// reset and the user's extra entry points first, then whichever
+	// interrupt vectors that code hasn't already claimed
+	analysis_init(&a, rom_buffer, file_size);
+	memcpy(all_entries + 1, options->entries, options->entry_count * sizeof(uint32_t));
+	analysis_run(&a, all_entries, 1 + options->entry_count);
+	analysis_run_vectors(&a);
+
+	if(options->verbose) {
+		fprintf(listing->file, "Code bytes......%zu (%d instructions)\n", a.code_bytes, a.instructions);
+		fprintf(listing->file, "Data bytes......%zu\n", file_size - a.code_bytes);
+		fprintf(listing->file, "Conflicts.......%d\n", a.conflicts);
+	}
+
+	while(pc < file_size) {
+
+		if(listing_has_label(listing, &a, pc)) {
+			listing_label(listing, &a, pc);
+		}
+
+		if(a.kind[pc] == BYTE_CODE) {
+			pc += listing_instruction(listing, rom_buffer, file_size, pc, &a);
+			continue;
+		}
+
+		// a data row runs up to 8 bytes, stopping at code or a label
+		int count = 1;
+		while(count < 8 && pc + count < file_size && a.kind[pc + count] == BYTE_DATA
+			&& !listing_has_label(listing, &a, pc + count)) {
+			count++;
+		}
+
+		listing_data(listing, rom_buffer, pc, count);
+		pc += count;
+	}
+
+	if(options->xrefs) {
+		xref_index index;
+
+		xref_build(&index, rom_buffer, file_size, a.kind);
+		listing_flush(listing);
+		xref_report(listing->file, &index, listing->symbols, &a);
+		xref_free(&index);
+	}
+
+	if(options->dot_path) {
+		export_blocks(&a, listing->symbols, options);
+	}
 
-	FILE* rom_file = fopen(fileName, "r");
+	analysis_free(&a);
+}
 
-	if(!rom_file) {
-		printf("please point to a valid ROM...\n");
-		exit(0);
-	} 
+// Lists one loaded ROM set; shared by the single-image and batch paths.
+static void disassemble_set(listing_buffer* listing, const rom_set* roms, const void* context) {
 
-	//set the file position indicator to the end of the file (measured in bytes)
-	fseek(rom_file, 0, SEEK_END);
-	//get the file position indicator to store the size of the file in bytes
-	file_size = ftell(rom_file);
-	//set the file position indicator to the beginning of the file
-	rewind(rom_file);
+	const disasm_options* options = context;
 
-	uint8_t* rom_buffer = (uint8_t*) malloc(file_size);
+	if(options->verbose) {
+		for(int i = 0; i < roms->file_count && roms->file_count > 1; i++) {
+			fprintf(listing->file, "%-16s%04x-%04x\n", roms->files[i].path, roms->files[i].address,
+				roms->files[i].address + roms->files[i].size - 1);
+		}
 
-	fread(rom_buffer, file_size, 1, rom_file);
-	fclose(rom_file);
+		fprintf(listing->file, "File size.......%zu\n", roms->size);
+	}
 
-	return rom_buffer;
+	if(options->recursive) {
+		list_recursive(listing, roms->image, roms->size, options);
+	} else {
+		list_linear(listing, roms->image, roms->size, options);
+	}
+}
+
+static void usage(void) {
+	printf("usage: [romfile[@address] | -]... [-v] [-r] [-e address]... [-s symbols] [-x] [-g cfg.dot]\n");
+	printf("       [romfile[@address]]... -d other[@address]... [-s symbols]\n");
+	printf("       -L list [-o dir] [-j threads] [-v] [-r] [-e address]... [-s symbols] [-x]\n");
 }
 
 int main(int argc, char** argv) {
@@ -893,24 +189,151 @@ int main(int argc, char** argv) {
 	display_intro();
 
 	if(argc < 2) {
-		printf("usage: [romfile]\n");
+		usage();
+		return 1;
 	}
 
-	uint8_t* rom_buffer = open_rom(argv[1]);
+	disasm_options options;
+	symbol_table symbols;
+	int have_symbols = 0;
+	rom_set roms;
+	rom_set other;
+	batch_options batch;
+
+	memset(&options, 0, sizeof(options));
+	memset(&batch, 0, sizeof(batch));
+	romset_init(&roms);
+	romset_init(&other);
+	batch.out_dir = ".";
 
-	if((argv[2] != NULL) && (strcmp(argv[2], "-v")) == 0) {
-		printf("File size.......%d\n", file_size);
+	for(int i = 1; i < argc; i++) {
+		if(argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+			if(!romset_add(&roms, argv[i])) {
+				return 1;
+			}
+		} else if(strcmp(argv[i], "-v") == 0) {
+			options.verbose = 1;
+		} else if(strcmp(argv[i], "-r") == 0) {
+			options.recursive = 1;
+		} else if(strcmp(argv[i], "-e") == 0 && i + 1 < argc && options.entry_count < MAX_ENTRIES) {
+			options.entries[options.entry_count++] = strtoul(argv[++i], NULL, 16);
+			options.recursive = 1;
+		} else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			have_symbols = symbols_load(&symbols, argv[++i]);
+		} else if(strcmp(argv[i], "-x") == 0) {
+			options.xrefs = 1;
+		} else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+			options.dot_path = argv[++i];
+			options.recursive = 1;
+		} else if(strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+			batch.list_path = argv[++i];
+		} else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			batch.out_dir = argv[++i];
+		} else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			batch.threads = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			if(!romset_add(&other, argv[++i])) {
+				return 1;
+			}
+		}
 	}
 
-	unsigned int pc = 0;
+	listing_prepare();
 
-	while(pc < file_size) {
+	// the intro went through printf; keep it ahead of the listing
+	fflush(stdout);
+
+	if(batch.list_path) {
+		if(options.dot_path) {
+			fprintf(stderr, "-g takes a single image; ignored in batch mode\n");
+			options.dot_path = NULL;
+		}
+
+		batch.symbols = have_symbols ? &symbols : NULL;
+		batch.worker = disassemble_set;
+		batch.context = &options;
+
+		int ok = batch_run(&batch);
+
+		if(have_symbols) {
+			symbols_free(&symbols);
+		}
+		romset_free(&roms);
+
+		return ok ? 0 : 1;
+	}
 
-		pc += disassemble(rom_buffer, pc);
+	if(roms.file_count == 0) {
+		usage();
+		return 1;
 	}
 
-	free(rom_buffer);
+	// diff mode: the positional set against the -d set
+	if(other.file_count) {
+		if(!romset_load(&roms) || !romset_load(&other)) {
+			return 1;
+		}
+
+		diff_summary summary = diff_report(stdout, roms.image, roms.size, other.image, other.size,
+			have_symbols ? &symbols : NULL);
+
+		if(have_symbols) {
+			symbols_free(&symbols);
+		}
+		romset_free(&roms);
+		romset_free(&other);
+
+		return summary.regions ? 2 : 0;
+	}
+
+	// stdin and pipes can't be mapped or seeked, so they are decoded as
+	// they arrive instead
+	if(roms.file_count == 1 && stream_wanted(roms.files[0].path)) {
+		if(options.recursive || options.xrefs) {
+			fprintf(stderr, "-r, -e, -x and -g need the whole image; streaming a linear listing\n");
+		}
+
+		listing_buffer listing;
+
+		listing_init(&listing, stdout, 0);
+		listing.symbols = have_symbols ? &symbols : NULL;
+
+		long long bytes = stream_disassemble(&listing, roms.files[0].path);
+
+		listing_free(&listing);
+
+		if(bytes < 0) {
+			fprintf(stderr, "please point to a valid ROM: %s\n", roms.files[0].path);
+		} else if(options.verbose) {
+			printf("File size.......%lld\n", bytes);
+		}
+
+		if(have_symbols) {
+			symbols_free(&symbols);
+		}
+		romset_free(&roms);
+
+		return bytes < 0 ? 1 : 0;
+	}
+
+	// the whole set is one image, so branches between chips resolve
+	if(!romset_load(&roms)) {
+		return 1;
+	}
+
+	listing_buffer listing;
+
+	listing_init(&listing, stdout, roms.size);
+	listing.symbols = have_symbols ? &symbols : NULL;
+
+	disassemble_set(&listing, &roms, &options);
+
+	listing_free(&listing);
+
+	if(have_symbols) {
+		symbols_free(&symbols);
+	}
+	romset_free(&roms);
 
 	return 0;
 }
-
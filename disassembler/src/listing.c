@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "listing.h"
+#include "../../common/opcodes.h"
+
+static char hex_pairs[256][2];
+static char opcode_prefix[256][OPCODE_TEXT_MAX];
+static uint8_t opcode_prefix_length[256];
+
+void listing_prepare(void) {
+
+	static const char digits[] = "0123456789abcdef";
+
+	for (int i = 0; i < 256; i++) {
+		hex_pairs[i][0] = digits[i >> 4];
+		hex_pairs[i][1] = digits[i & 0xF];
+	}
+
+	// The prefix is the formatted instruction minus its operand digits, so
+	// listings read exactly like opcode_format() output.
+	for (int op = 0; op < 256; op++) {
+		uint8_t code[3] = { op, 0, 0 };
+		char text[OPCODE_TEXT_MAX];
+		int length;
+
+		opcode_format(code, NULL, text);
+		length = strlen(text);
+
+		switch (opcode_table[op].operand) {
+		case OPERAND_BYTE:
+		case OPERAND_PORT:
+			length -= 2;
+			break;
+		case OPERAND_WORD:
+		case OPERAND_ADDRESS:
+			length -= 4;
+			break;
+		default:
+			break;
+		}
+
+		memcpy(opcode_prefix[op], text, length);
+		opcode_prefix_length[op] = length;
+	}
+}
+
+void listing_init(listing_buffer* listing, FILE* file, size_t image_size) {
+
+	listing->file = file;
+	listing->data = malloc(LISTING_BUFFER_SIZE);
+	listing->used = 0;
+	listing->size = LISTING_BUFFER_SIZE;
+	listing->address_digits = 4;
+	listing->symbols = NULL;
+
+	while (listing->address_digits < 8 && image_size > ((size_t)1 << (listing->address_digits * 4))) {
+		listing->address_digits += 2;
+	}
+}
+
+void listing_flush(listing_buffer* listing) {
+	fwrite(listing->data, 1, listing->used, listing->file);
+	listing->used = 0;
+}
+
+void listing_free(listing_buffer* listing) {
+	listing_flush(listing);
+	free(listing->data);
+	listing->data = NULL;
+}
+
+static inline char* put_hex(char* out, uint8_t value) {
+	out[0] = hex_pairs[value][0];
+	out[1] = hex_pairs[value][1];
+	return out + 2;
+}
+
+static inline char* put_address(char* out, uint32_t address, int digits) {
+	for (int shift = (digits - 2) * 4; shift >= 0; shift -= 8) {
+		out = put_hex(out, (address >> shift) & 0xFF);
+	}
+	return out;
+}
+
+// Copies the name for `address` to `out`: its symbol, else its generated
+// label. Returns the length, 0 if it has neither.
+static int name_for(const listing_buffer* listing, const analysis* labels, uint32_t address, char* out) {
+
+	const char* symbol = symbols_lookup(listing->symbols, address);
+
+	if (symbol) {
+		int length = strlen(symbol);
+		length = length < OPCODE_NAME_MAX ? length : OPCODE_NAME_MAX;
+		memcpy(out, symbol, length);
+		return length;
+	}
+
+	return labels ? analysis_label_name(labels, address, out) : 0;
+}
+
+static inline void make_room(listing_buffer* listing) {
+	if (listing->size - listing->used < LISTING_MAX_LINE) {
+		listing_flush(listing);
+	}
+}
+
+int listing_instruction(listing_buffer* listing, const uint8_t* image, size_t image_size, uint32_t pc,
+	const analysis* labels) {
+	return listing_code(listing, image + pc, image_size - pc, pc, labels);
+}
+
+int listing_code(listing_buffer* listing, const uint8_t* code, size_t available, uint32_t pc,
+	const analysis* labels) {
+
+	make_room(listing);
+
+	char* out = listing->data + listing->used;
+	uint8_t op = code[0];
+	const opcode_info* info = &opcode_table[op];
+	int length = info->length;
+
+	out = put_address(out, pc, listing->address_digits);
+	*out++ = ' ';
+	*out++ = ' ';
+
+	if ((size_t)length > available) {
+		memcpy(out, "DB     ", 7);
+		out = put_hex(out + 7, op);
+		length = 1;
+	} else {
+		memcpy(out, opcode_prefix[op], opcode_prefix_length[op]);
+		out += opcode_prefix_length[op];
+
+		int named = 0;
+
+		if (info->operand == OPERAND_WORD || info->operand == OPERAND_ADDRESS) {
+			uint32_t target = code[1] | code[2] << 8;
+
+			// generated labels only exist for branch targets
+			named = name_for(listing, info->flow != FLOW_NEXT ? labels : NULL, target, out);
+			out += named;
+		}
+
+		if (info->operand == OPERAND_BYTE || info->operand == OPERAND_PORT) {
+			out = put_hex(out, code[1]);
+		} else if (info->operand != OPERAND_NONE && !named) {
+			out = put_hex(out, code[2]);
+			out = put_hex(out, code[1]);
+		}
+	}
+
+	*out++ = '\n';
+	listing->used = out - listing->data;
+
+	return length;
+}
+
+void listing_data(listing_buffer* listing, const uint8_t* image, uint32_t pc, int count) {
+
+	make_room(listing);
+
+	char* out = listing->data + listing->used;
+
+	out = put_address(out, pc, listing->address_digits);
+	memcpy(out, "  DB     ", 9);
+	out += 9;
+
+	for (int i = 0; i < count; i++) {
+		if (i) {
+			*out++ = ',';
+			*out++ = ' ';
+		}
+		out = put_hex(out, image[pc + i]);
+	}
+
+	*out++ = '\n';
+	listing->used = out - listing->data;
+}
+
+int listing_has_label(const listing_buffer* listing, const analysis* labels, uint32_t address) {
+	return (labels && labels->label[address]) || symbols_lookup(listing->symbols, address);
+}
+
+void listing_label(listing_buffer* listing, const analysis* labels, uint32_t address) {
+
+	make_room(listing);
+
+	char* out = listing->data + listing->used;
+
+	if (labels && (labels->label[address] & (LABEL_CALL | LABEL_ENTRY))) {
+		*out++ = '\n';
+	}
+
+	out += name_for(listing, labels, address, out);
+	*out++ = ':';
+	*out++ = '\n';
+	listing->used = out - listing->data;
+}
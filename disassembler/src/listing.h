@@ -0,0 +1,57 @@
+#ifndef _LISTING_H
+#define _LISTING_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "analysis.h"
+#include "../../common/symbols.h"
+
+// Buffered listing writer. Lines are formatted straight into a large buffer
+// from per-opcode prefixes built once at startup, with hand-rolled hex, and
+// written out in big chunks. Each listing_buffer is independent, so separate
+// threads can each own one.
+
+#define LISTING_BUFFER_SIZE     (1 << 20)
+#define LISTING_MAX_LINE        128         // flush when less than this is left
+
+typedef struct {
+    FILE* file;
+    char* data;
+    size_t used;
+    size_t size;
+    int address_digits;         // 4 for a 64 KiB image, more for bigger ones
+    const symbol_table* symbols;    // optional names, ahead of generated labels
+} listing_buffer;
+
+// Builds the shared prefix and hex tables; call once before any listing.
+void listing_prepare(void);
+
+void listing_init(listing_buffer* listing, FILE* file, size_t image_size);
+void listing_flush(listing_buffer* listing);
+void listing_free(listing_buffer* listing);
+
+// Writes one "addr  MNEMONIC operands" line for the instruction at `pc` and
+// returns its length. An instruction cut off by the end of the image is
+// listed as a single DB byte. 16-bit operands with a symbol are printed by
+// name; with `labels`, so are branch targets that have a generated label.
+int listing_instruction(listing_buffer* listing, const uint8_t* image, size_t image_size, uint32_t pc,
+	const analysis* labels);
+
+// The same for an instruction whose bytes start at `code`, with `available`
+// bytes left, listed at address `pc`. For callers that don't hold the whole
+// image, such as the streaming decoder.
+int listing_code(listing_buffer* listing, const uint8_t* code, size_t available, uint32_t pc,
+	const analysis* labels);
+
+// Writes "addr  DB     xx, xx, ..." for `count` (at most 16) data bytes.
+void listing_data(listing_buffer* listing, const uint8_t* image, uint32_t pc, int count);
+
+// Does `address` get a label line (a symbol, or a generated label)?
+int listing_has_label(const listing_buffer* listing, const analysis* labels, uint32_t address);
+
+// Writes a "name:" line, preceded by a blank line for subroutines.
+void listing_label(listing_buffer* listing, const analysis* labels, uint32_t address);
+
+#endif
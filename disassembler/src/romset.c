@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "romset.h"
+
+#define ADDRESS_UNSET   0xFFFFFFFF
+
+void romset_init(rom_set* set) {
+	memset(set, 0, sizeof(*set));
+}
+
+bool romset_add(rom_set* set, const char* spec) {
+
+	if(set->file_count == ROMSET_MAX_FILES) {
+		fprintf(stderr, "too many ROM files (at most %d)\n", ROMSET_MAX_FILES);
+		return false;
+	}
+
+	const char* at = strrchr(spec, '@');
+	uint32_t address = ADDRESS_UNSET;
+
+	// "@" must be followed by a hex load address inside the 64 KiB map
+	if(at) {
+		char* end;
+		unsigned long value = strtoul(at + 1, &end, 16);
+
+		if(!isxdigit((unsigned char)at[1]) || *end != '\0' || value > 0xFFFF) {
+			fprintf(stderr, "bad load address in %s (expected file@hexaddr, at most ffff)\n", spec);
+			return false;
+		}
+		address = (uint32_t)value;
+	}
+
+	rom_file* file = &set->files[set->file_count++];
+	size_t length = at ? (size_t)(at - spec) : strlen(spec);
+	char* path = malloc(length + 1);
+
+	// keep only the path part of the spec
+	memcpy(path, spec, length);
+	path[length] = '\0';
+
+	file->path = path;
+	file->address = address;
+
+	return true;
+}
+
+static bool read_file(const char* path, uint8_t* out, size_t size) {
+
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0) {
+		return false;
+	}
+
+	size_t done = 0;
+
+	while(done < size) {
+		ssize_t got = read(fd, out + done, size - done);
+
+		if(got <= 0) {
+			break;
+		}
+
+		done += got;
+	}
+
+	close(fd);
+
+	return done == size;
+}
+
+bool romset_load(rom_set* set) {
+
+	uint32_t next = 0;
+
+	// sizes and placement first, so the view can be mapped in one piece
+	for(int i = 0; i < set->file_count; i++) {
+		rom_file* file = &set->files[i];
+		struct stat info;
+
+		if(stat(file->path, &info) != 0 || !S_ISREG(info.st_mode)) {
+			fprintf(stderr, "please point to a valid ROM: %s\n", file->path);
+			return false;
+		}
+
+		file->size = info.st_size;
+
+		if(file->address == ADDRESS_UNSET) {
+			file->address = next;
+		}
+
+		next = file->address + file->size;
+
+		if(next > set->size) {
+			set->size = next;
+		}
+
+		for(int j = 0; j < i; j++) {
+			rom_file* other = &set->files[j];
+
+			if(file->address < other->address + other->size && other->address < file->address + file->size) {
+				fprintf(stderr, "warning: %s overlaps %s\n", file->path, other->path);
+			}
+		}
+	}
+
+	set->mapped_size = set->size ? set->size : 1;
+
+	// A single file at address 0 is mapped directly; anything else is read
+	// into place in an anonymous mapping.
+	if(set->file_count == 1 && set->files[0].address == 0 && set->size) {
+		int fd = open(set->files[0].path, O_RDONLY);
+
+		if(fd >= 0) {
+			void* map = mmap(NULL, set->mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+
+			if(map != MAP_FAILED) {
+				set->image = map;
+				return true;
+			}
+		}
+	}
+
+	void* map = mmap(NULL, set->mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(map == MAP_FAILED) {
+		fprintf(stderr, "could not map %zu bytes\n", set->mapped_size);
+		return false;
+	}
+
+	set->image = map;
+
+	for(int i = 0; i < set->file_count; i++) {
+		rom_file* file = &set->files[i];
+
+		if(!read_file(file->path, set->image + file->address, file->size)) {
+			fprintf(stderr, "could not read %s\n", file->path);
+			romset_free(set);
+			return false;
+		}
+	}
+
+	mprotect(set->image, set->mapped_size, PROT_READ);
+
+	return true;
+}
+
+void romset_free(rom_set* set) {
+
+	if(set->image) {
+		munmap(set->image, set->mapped_size);
+		set->image = NULL;
+	}
+
+	for(int i = 0; i < set->file_count; i++) {
+		free((char*)set->files[i].path);
+	}
+
+	set->file_count = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _ROMSET_H
+#define _ROMSET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// A set of ROM files placed at their load addresses in one contiguous,
+// read-only mmap'd image, indexed by address, so branches between chips
+// resolve and the analysis passes run once over the whole set. Gaps between
+// files read as zero.
+//
+// Each file is given as "path" or "path@address" (hex). Without an address
+// a file goes right after the previous one, the way the emulator loads
+// invaders.h/g/f/e into 0x0000-0x1FFF.
+
+#define ROMSET_MAX_FILES    32
+
+typedef struct {
+    const char* path;
+    uint32_t address;
+    uint32_t size;
+} rom_file;
+
+typedef struct {
+    rom_file files[ROMSET_MAX_FILES];
+    int file_count;
+    uint8_t* image;
+    size_t size;                // highest load address + 1
+    size_t mapped_size;
+} rom_set;
+
+void romset_init(rom_set* set);
+bool romset_add(rom_set* set, const char* spec);
+bool romset_load(rom_set* set);
+void romset_free(rom_set* set);
+
+#endif
@@ -0,0 +1,88 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "stream.h"
+#include "../../common/opcodes.h"
+
+bool stream_wanted(const char* path) {
+
+	struct stat info;
+
+	if (strcmp(path, "-") == 0) {
+		return true;
+	}
+
+	return stat(path, &info) == 0 && !S_ISREG(info.st_mode) && !S_ISDIR(info.st_mode);
+}
+
+long long stream_disassemble(listing_buffer* listing, const char* path) {
+
+	// room for a chunk plus the partial instruction carried from the last one
+	static uint8_t buffer[STREAM_CHUNK_SIZE + 2];
+
+	int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	uint32_t pc = 0;
+	size_t filled = 0;
+	long long total = 0;
+	bool done = false;
+
+	while (!done) {
+		ssize_t got = read(fd, buffer + filled, STREAM_CHUNK_SIZE);
+
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (got <= 0) {
+			done = true;
+		} else {
+			filled += got;
+			total += got;
+		}
+
+		size_t offset = 0;
+
+		// Only whole instructions until end of input; after that the tail is
+		// listed too, and a cut-off instruction comes out as DB.
+		while (offset < filled && (done || offset + opcode_table[buffer[offset]].length <= filled)) {
+
+			// 8080 memory is 64 KiB, but a pipe can carry more
+			if (listing->address_digits < 8 && pc >> (listing->address_digits * 4)) {
+				listing->address_digits += 2;
+			}
+
+			if (listing_has_label(listing, NULL, pc)) {
+				listing_label(listing, NULL, pc);
+			}
+
+			int length = listing_code(listing, buffer + offset, filled - offset, pc, NULL);
+
+			offset += length;
+			pc += length;
+		}
+
+		memmove(buffer, buffer + offset, filled - offset);
+		filled -= offset;
+
+		listing_flush(listing);
+		fflush(listing->file);
+	}
+
+	if (fd != STDIN_FILENO) {
+		close(fd);
+	}
+
+	return total;
+}
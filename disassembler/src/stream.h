@@ -0,0 +1,25 @@
+#ifndef _STREAM_H
+#define _STREAM_H
+
+#include <stdbool.h>
+
+#include "listing.h"
+
+// Streaming linear disassembly for input that can't be mapped or seeked:
+// stdin ("-"), pipes, FIFOs and character devices. Bytes are decoded out of
+// a fixed chunk buffer as they arrive; the last few bytes of a chunk that
+// don't hold a whole instruction are carried into the next read. The listing
+// is flushed after every read, so output keeps pace with the input, and
+// memory use is the same whatever the input size.
+
+#define STREAM_CHUNK_SIZE   (64 * 1024)
+
+// Should `path` be streamed instead of loaded as a ROM set?
+bool stream_wanted(const char* path);
+
+// Lists everything readable from `path` until end of input, addresses
+// starting at 0. Returns the number of bytes read, or -1 if `path` could not
+// be opened.
+long long stream_disassemble(listing_buffer* listing, const char* path);
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "xref.h"
+#include "../../common/opcodes.h"
+
+#define NOT_A_REFERENCE     0xFF
+
+static const char* kind_names[XREF_KIND_COUNT] = { "call", "jump", "read", "write", "pointer" };
+
+// Reference kind per opcode; RST is a call to a fixed vector.
+static void classify(uint8_t* kinds) {
+
+	for (int op = 0; op < 256; op++) {
+		const opcode_info* info = &opcode_table[op];
+
+		kinds[op] = NOT_A_REFERENCE;
+
+		if (info->flow == FLOW_CALL || info->flow == FLOW_CALL_IF || info->flow == FLOW_RST) {
+			kinds[op] = XREF_CALL;
+		} else if (info->flow == FLOW_JUMP || info->flow == FLOW_JUMP_IF) {
+			kinds[op] = XREF_JUMP;
+		} else if (strcmp(info->mnemonic, "LDA") == 0 || strcmp(info->mnemonic, "LHLD") == 0) {
+			kinds[op] = XREF_READ;
+		} else if (strcmp(info->mnemonic, "STA") == 0 || strcmp(info->mnemonic, "SHLD") == 0) {
+			kinds[op] = XREF_WRITE;
+		} else if (strcmp(info->mnemonic, "LXI") == 0) {
+			kinds[op] = XREF_POINTER;
+		}
+	}
+}
+
+static inline uint32_t target_of(const uint8_t* code) {
+	return opcode_table[code[0]].flow == FLOW_RST ? (code[0] & 0x38) : (uint32_t)(code[1] | code[2] << 8);
+}
+
+// First instruction start at or after pc: the next BYTE_CODE byte, or pc
+// itself for a linear decode.
+static inline uint32_t next_instruction(const uint8_t* kind, size_t size, uint32_t pc) {
+	if (kind) {
+		while (pc < size && kind[pc] != BYTE_CODE) {
+			pc++;
+		}
+	}
+	return pc;
+}
+
+void xref_build(xref_index* index, const uint8_t* image, size_t size, const uint8_t* kind) {
+
+	uint8_t kinds[256];
+	classify(kinds);
+
+	index->start = calloc(0x10001, sizeof(uint32_t));
+	index->count = 0;
+
+	// count per target, then turn the counts into start offsets
+	for (uint32_t pc = next_instruction(kind, size, 0); pc < size; pc = next_instruction(kind, size, pc + opcode_table[image[pc]].length)) {
+		if (pc + opcode_table[image[pc]].length > size) {
+			break;
+		}
+		if (kinds[image[pc]] != NOT_A_REFERENCE) {
+			index->start[target_of(image + pc) + 1]++;
+			index->count++;
+		}
+	}
+
+	for (int address = 0; address < 0x10000; address++) {
+		index->start[address + 1] += index->start[address];
+	}
+
+	index->refs = malloc((index->count ? index->count : 1) * sizeof(xref));
+
+	uint32_t* fill = malloc(0x10000 * sizeof(uint32_t));
+	memcpy(fill, index->start, 0x10000 * sizeof(uint32_t));
+
+	for (uint32_t pc = next_instruction(kind, size, 0); pc < size; pc = next_instruction(kind, size, pc + opcode_table[image[pc]].length)) {
+		uint8_t ref_kind = kinds[image[pc]];
+
+		if (pc + opcode_table[image[pc]].length > size) {
+			break;
+		}
+
+		if (ref_kind != NOT_A_REFERENCE) {
+			xref* ref = &index->refs[fill[target_of(image + pc)]++];
+			ref->from = pc;
+			ref->kind = ref_kind;
+		}
+	}
+
+	free(fill);
+}
+
+void xref_free(xref_index* index) {
+	free(index->start);
+	free(index->refs);
+	index->start = NULL;
+	index->refs = NULL;
+}
+
+void xref_report(FILE* out, const xref_index* index, const symbol_table* symbols, const analysis* labels) {
+
+	fprintf(out, "\n; cross references: %u\n", index->count);
+
+	for (uint32_t address = 0; address < 0x10000; address++) {
+		uint32_t first = index->start[address];
+		uint32_t end = index->start[address + 1];
+
+		if (first == end) {
+			continue;
+		}
+
+		char generated[LABEL_NAME_MAX];
+		const char* name = symbols_lookup(symbols, address);
+
+		if (!name && labels && analysis_label_name(labels, address, generated)) {
+			name = generated;
+		}
+
+		fprintf(out, "%04x  %-16s", address, name ? name : "");
+
+		for (int k = 0; k < XREF_KIND_COUNT; k++) {
+			int printed = 0;
+
+			for (uint32_t i = first; i < end; i++) {
+				if (index->refs[i].kind != k) {
+					continue;
+				}
+				if (!printed) {
+					fprintf(out, "  %s", kind_names[k]);
+					printed = 1;
+				}
+				fprintf(out, " %04x", index->refs[i].from);
+			}
+		}
+
+		fprintf(out, "\n");
+	}
+}
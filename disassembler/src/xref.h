@@ -0,0 +1,45 @@
+#ifndef _XREF_H
+#define _XREF_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "analysis.h"
+#include "../../common/symbols.h"
+
+// Cross-reference index: for every 16-bit address, the instructions that
+// call it, jump to it, read or write it (LDA / LHLD, STA / SHLD) or load it
+// as a pointer (LXI). Stored compressed: the references to address a are
+// refs[start[a]] .. refs[start[a + 1] - 1], in ascending source order.
+
+typedef enum {
+    XREF_CALL,
+    XREF_JUMP,
+    XREF_READ,
+    XREF_WRITE,
+    XREF_POINTER,
+    XREF_KIND_COUNT,
+} xref_kind;
+
+typedef struct {
+    uint32_t from;
+    uint8_t kind;
+} xref;
+
+typedef struct {
+    uint32_t* start;            // 0x10001 entries
+    xref* refs;
+    uint32_t count;
+} xref_index;
+
+// Indexes the instructions marked BYTE_CODE in `kind`, or every instruction
+// of a linear decode from offset 0 when `kind` is NULL.
+void xref_build(xref_index* index, const uint8_t* image, size_t size, const uint8_t* kind);
+void xref_free(xref_index* index);
+
+// Prints one line per referenced address, named from `symbols` or the
+// analysis labels when available.
+void xref_report(FILE* out, const xref_index* index, const symbol_table* symbols, const analysis* labels);
+
+#endif
@@ -0,0 +1,413 @@
+// bench - headless Space Invaders macro benchmark.
+//
+//   ./8080-bench [--frames N] [--reps N] [--warmup N] [--json file] [--perf]
+//                [--history file] [--no-history] [--compare commit|last] [--threshold pct]
+//                <rom1> <rom2> <rom3> <rom4>
+//
+// --perf adds host hardware counters (cycles, instructions, IPC, branch
+// mispredicts, L1i/L1d misses) for each backend, averaged per repetition.
+//
+// Every run appends one line per backend to a history file (commit, compiler,
+// flags, medians and the raw frames/s repetitions). --compare tests the new
+// repetitions against the latest matching history entry for a commit with a
+// Mann-Whitney U test and exits non-zero if frames/s dropped by more than
+// --threshold percent (default 5) with p < 0.05.
+//
+// Loads the ROM set the same way the emulator does, then for every CPU
+// backend runs a fixed number of attract-mode frames from reset with no
+// window, input or audio. Each repetition starts from the same memory image,
+// so every run executes exactly the same instructions. Results are printed
+// and written as JSON.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "../src/cpu.h"
+#include "../src/rom.h"
+#include "../src/machine.h"
+#include "../src/metrics.h"
+#include "perfctr.h"
+#include "history.h"
+
+#define DEFAULT_FRAMES      600     // ten seconds of game time
+#define DEFAULT_REPS        10
+#define DEFAULT_WARMUP      2
+#define MAX_REPS            HISTORY_MAX_REPS
+#define DEFAULT_THRESHOLD   5.0     // percent
+#define SIGNIFICANCE        0.05
+
+// The Makefile passes the commit and compile flags in; a plain gcc build
+// still works, it just records them as unknown.
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT        "unknown"
+#endif
+#ifndef BENCH_CFLAGS
+#define BENCH_CFLAGS        "unknown"
+#endif
+#if defined(__clang__)
+#define BENCH_COMPILER      __VERSION__
+#elif defined(__GNUC__)
+#define BENCH_COMPILER      "gcc " __VERSION__
+#else
+#define BENCH_COMPILER      "unknown"
+#endif
+
+typedef struct {
+    const char* name;
+    const char* flag_engine;
+    void (*run_frame)(cpu* state);
+} bench_backend;
+
+// Every CPU core that can run a frame. There is one interpreter today (the
+// switch in execute(), with flags held in the cond bitfield); alternate cores
+// get added here and are picked up by every benchmark.
+static const bench_backend backends[] = {
+    { "switch", "bitfield", run_frame },
+};
+
+#define BACKEND_COUNT   (int)(sizeof(backends) / sizeof(backends[0]))
+
+typedef struct {
+    double mean;
+    double median;
+    double stddev;
+    double min;
+    double max;
+} bench_stats;
+
+typedef struct {
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t ns;
+    double fps;
+    double mhz;
+    double ns_per_instruction;
+} bench_rep;
+
+static uint8_t rom_image[0x10000];
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static bench_stats compute_stats(const double* values, int count) {
+
+    bench_stats stats = { 0 };
+    double* sorted = malloc(sizeof(double) * count);
+
+    memcpy(sorted, values, sizeof(double) * count);
+    qsort(sorted, count, sizeof(double), compare_doubles);
+
+    for (int i = 0; i < count; i++) {
+        stats.mean += sorted[i];
+    }
+    stats.mean /= count;
+
+    for (int i = 0; i < count; i++) {
+        stats.stddev += (sorted[i] - stats.mean) * (sorted[i] - stats.mean);
+    }
+    stats.stddev = count > 1 ? sqrt(stats.stddev / (count - 1)) : 0.0;
+
+    stats.median = count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    stats.min = sorted[0];
+    stats.max = sorted[count - 1];
+
+    free(sorted);
+    return stats;
+}
+
+// perf may be NULL; otherwise the counts for this run are added to perf_total.
+static bench_rep run_once(const bench_backend* backend, int frames, perf_counters* perf, perf_sample* perf_total) {
+
+    cpu* state = init_cpu();
+    memcpy(state->memory, rom_image, sizeof(rom_image));
+    machine_init();
+
+    if (perf) {
+        perfctr_start(perf);
+    }
+
+    uint64_t start = metrics_now_ns();
+
+    for (int i = 0; i < frames; i++) {
+        backend->run_frame(state);
+    }
+
+    uint64_t end = metrics_now_ns();
+
+    if (perf) {
+        perfctr_stop(perf, perf_total);
+    }
+
+    bench_rep rep;
+    rep.instructions = state->instruction_count;
+    rep.cycles = state->cycle_count;
+    rep.ns = end - start;
+    rep.fps = frames * 1e9 / rep.ns;
+    rep.mhz = rep.cycles * 1e3 / rep.ns;
+    rep.ns_per_instruction = (double)rep.ns / rep.instructions;
+
+    free(state->memory);
+    free(state);
+
+    return rep;
+}
+
+static void write_stats(FILE* out, const char* name, bench_stats stats, const char* trailer) {
+    fprintf(out, "      \"%s\": {\"mean\": %.4f, \"median\": %.4f, \"stddev\": %.4f, \"min\": %.4f, \"max\": %.4f}%s\n",
+        name, stats.mean, stats.median, stats.stddev, stats.min, stats.max, trailer);
+}
+
+static void print_perf(const perf_sample* perf, int reps, uint64_t emulated_instructions) {
+
+    printf("  host per rep:");
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (perf->valid[i]) {
+            printf("  %s %llu", perf_counter_names[i], (unsigned long long)(perf->value[i] / reps));
+        }
+    }
+
+    if (perf->valid[PERF_CYCLES] && perf->valid[PERF_INSTRUCTIONS] && perf->value[PERF_CYCLES]) {
+        printf("  ipc %.2f", (double)perf->value[PERF_INSTRUCTIONS] / perf->value[PERF_CYCLES]);
+    }
+
+    if (perf->valid[PERF_INSTRUCTIONS] && emulated_instructions) {
+        printf("  host instr/8080 instr %.1f",
+            (double)perf->value[PERF_INSTRUCTIONS] / reps / emulated_instructions);
+    }
+
+    printf("\n");
+}
+
+static void write_perf(FILE* out, const perf_sample* perf, int reps) {
+
+    fprintf(out, "      \"perf\": {");
+
+    int first = 1;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (perf->valid[i]) {
+            fprintf(out, "%s\"%s\": %llu", first ? "" : ", ", perf_counter_names[i],
+                (unsigned long long)(perf->value[i] / reps));
+            first = 0;
+        }
+    }
+
+    if (perf->valid[PERF_CYCLES] && perf->valid[PERF_INSTRUCTIONS] && perf->value[PERF_CYCLES]) {
+        fprintf(out, "%s\"ipc\": %.4f", first ? "" : ", ",
+            (double)perf->value[PERF_INSTRUCTIONS] / perf->value[PERF_CYCLES]);
+    }
+
+    fprintf(out, "},\n");
+}
+
+static int int_arg(int argc, char** argv, const char* flag, int fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            return atoi(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+static const char* string_arg(int argc, char** argv, const char* flag, const char* fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// Returns true if the current repetitions are a significant regression from
+// the baseline entry.
+static bool compare_to_baseline(const history_entry* current, const history_entry* baseline, double threshold) {
+
+    bench_stats base = compute_stats(baseline->fps_reps, baseline->rep_count);
+    bench_stats now = compute_stats(current->fps_reps, current->rep_count);
+
+    double change = (now.median - base.median) / base.median * 100.0;
+    double p = mann_whitney_p(current->fps_reps, current->rep_count, baseline->fps_reps, baseline->rep_count);
+    bool regression = change < -threshold && p < SIGNIFICANCE;
+
+    printf("  vs %s (%d reps): %.1f -> %.1f frames/s, %+.2f%%, p = %.4f%s\n",
+        baseline->commit, baseline->rep_count, base.median, now.median, change, p,
+        regression ? "  REGRESSION" : p < SIGNIFICANCE ? "  (significant)" : "");
+
+    return regression;
+}
+
+int main(int argc, char** argv) {
+
+    int frames = int_arg(argc, argv, "--frames", DEFAULT_FRAMES);
+    int reps = int_arg(argc, argv, "--reps", DEFAULT_REPS);
+    int warmup = int_arg(argc, argv, "--warmup", DEFAULT_WARMUP);
+    const char* json_path = string_arg(argc, argv, "--json", "bench.json");
+    const char* history_path = string_arg(argc, argv, "--history", HISTORY_DEFAULT_PATH);
+    const char* compare = string_arg(argc, argv, "--compare", NULL);
+    const char* threshold_arg = string_arg(argc, argv, "--threshold", NULL);
+    double threshold = threshold_arg ? atof(threshold_arg) : DEFAULT_THRESHOLD;
+    bool record_history = true;
+    bool regressed = false;
+
+    perf_counters perf_storage;
+    perf_counters* perf = NULL;
+
+    if (reps < 1 || reps > MAX_REPS || frames < 1) {
+        printf("--reps must be 1..%d and --frames at least 1\n", MAX_REPS);
+        return 1;
+    }
+
+    // ROM paths are the arguments that aren't flags or flag values
+    char* roms[4];
+    int rom_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            if (perfctr_open(&perf_storage)) {
+                perf = &perf_storage;
+            } else {
+                printf("hardware counters unavailable (perf_event_open failed), continuing without\n");
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--no-history") == 0) {
+            record_history = false;
+            continue;
+        }
+        if (strncmp(argv[i], "--", 2) == 0) {
+            i++;
+            continue;
+        }
+        if (rom_count < 4) {
+            roms[rom_count++] = argv[i];
+        }
+    }
+
+    if (rom_count != 4) {
+        printf("usage: 8080-bench [--frames N] [--reps N] [--warmup N] [--json file] [--perf]\n"
+               "                  [--history file] [--no-history] [--compare commit|last] [--threshold pct]\n"
+               "                  <rom1> <rom2> <rom3> <rom4>\n");
+        return 1;
+    }
+
+    // Load once through the emulator's own loader, then keep a pristine copy
+    // that every repetition starts from.
+    cpu* loader = init_cpu();
+    for (int i = 0; i < 4; i++) {
+        uint8_t* rom = open_rom(roms[i]);
+        write_rom(loader, rom, file_size);
+        free(rom);
+    }
+    memcpy(rom_image, loader->memory, sizeof(rom_image));
+
+    FILE* json = fopen(json_path, "w");
+
+    if (!json) {
+        printf("could not write %s\n", json_path);
+        return 1;
+    }
+
+    fprintf(json, "{\n  \"frames\": %d,\n  \"reps\": %d,\n  \"warmup\": %d,\n  \"cases\": [\n", frames, reps, warmup);
+
+    printf("%-10s %-10s %12s %10s %10s %10s\n", "backend", "flags", "frames/s", "+-", "MHz", "ns/instr");
+
+    static history_entry current;
+    static history_entry baseline;
+
+    double* fps = current.fps_reps;
+    double mhz[MAX_REPS];
+    double nspi[MAX_REPS];
+
+    for (int b = 0; b < BACKEND_COUNT; b++) {
+        const bench_backend* backend = &backends[b];
+
+        for (int i = 0; i < warmup; i++) {
+            run_once(backend, frames, NULL, NULL);
+        }
+
+        bench_rep rep;
+        perf_sample perf_total;
+        memset(&perf_total, 0, sizeof(perf_total));
+
+        for (int i = 0; i < reps; i++) {
+            rep = run_once(backend, frames, perf, &perf_total);
+            fps[i] = rep.fps;
+            mhz[i] = rep.mhz;
+            nspi[i] = rep.ns_per_instruction;
+        }
+
+        bench_stats fps_stats = compute_stats(fps, reps);
+        bench_stats mhz_stats = compute_stats(mhz, reps);
+        bench_stats nspi_stats = compute_stats(nspi, reps);
+
+        printf("%-10s %-10s %12.1f %10.1f %10.2f %10.2f\n", backend->name, backend->flag_engine,
+            fps_stats.median, fps_stats.stddev, mhz_stats.median, nspi_stats.median);
+
+        if (perf) {
+            print_perf(&perf_total, reps, rep.instructions);
+        }
+
+        fprintf(json, "    {\n      \"backend\": \"%s\",\n      \"flag_engine\": \"%s\",\n", backend->name, backend->flag_engine);
+        fprintf(json, "      \"instructions\": %llu,\n      \"cycles\": %llu,\n",
+            (unsigned long long)rep.instructions, (unsigned long long)rep.cycles);
+        write_stats(json, "fps", fps_stats, ",");
+        write_stats(json, "emulated_mhz", mhz_stats, ",");
+        write_stats(json, "ns_per_instruction", nspi_stats, ",");
+
+        if (perf) {
+            write_perf(json, &perf_total, reps);
+        }
+
+        fprintf(json, "      \"fps_reps\": [");
+        for (int i = 0; i < reps; i++) {
+            fprintf(json, "%s%.4f", i ? ", " : "", fps[i]);
+        }
+        fprintf(json, "]\n    }%s\n", b + 1 < BACKEND_COUNT ? "," : "");
+
+        snprintf(current.commit, sizeof(current.commit), "%s", BENCH_COMMIT);
+        snprintf(current.compiler, sizeof(current.compiler), "%s", BENCH_COMPILER);
+        snprintf(current.flags, sizeof(current.flags), "%s", BENCH_CFLAGS);
+        snprintf(current.backend, sizeof(current.backend), "%s", backend->name);
+        snprintf(current.flag_engine, sizeof(current.flag_engine), "%s", backend->flag_engine);
+        current.frames = frames;
+        current.fps_median = fps_stats.median;
+        current.mhz_median = mhz_stats.median;
+        current.ns_per_instruction_median = nspi_stats.median;
+        current.rep_count = reps;
+
+        // compare before appending so "last" never matches this run
+        if (compare) {
+            if (history_find(history_path, compare, backend->name, backend->flag_engine, frames, &baseline)) {
+                regressed |= compare_to_baseline(&current, &baseline, threshold);
+            } else {
+                printf("  no %s entry for %s/%s at %d frames in %s\n",
+                    compare, backend->name, backend->flag_engine, frames, history_path);
+            }
+        }
+
+        if (record_history) {
+            history_append(history_path, &current);
+        }
+    }
+
+    fprintf(json, "  ]\n}\n");
+    fclose(json);
+
+    if (perf) {
+        perfctr_close(perf);
+    }
+
+    printf("results written to %s\n", json_path);
+
+    if (regressed) {
+        printf("performance regression beyond %.1f%%\n", threshold);
+        return 2;
+    }
+
+    return 0;
+}
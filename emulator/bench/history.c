@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "history.h"
+
+#define HISTORY_MAX_LINE    (HISTORY_MAX_REPS * 24 + 1024)
+
+bool history_append(const char* path, const history_entry* entry) {
+
+    FILE* out = fopen(path, "a");
+
+    if (!out) {
+        fprintf(stderr, "could not append to %s\n", path);
+        return false;
+    }
+
+    fprintf(out, "{\"time\": %lld, \"commit\": \"%s\", \"compiler\": \"%s\", \"flags\": \"%s\", "
+        "\"backend\": \"%s\", \"flag_engine\": \"%s\", \"frames\": %d, "
+        "\"fps_median\": %.4f, \"emulated_mhz_median\": %.4f, \"ns_per_instruction_median\": %.4f, \"fps_reps\": [",
+        (long long)time(NULL), entry->commit, entry->compiler, entry->flags,
+        entry->backend, entry->flag_engine, entry->frames,
+        entry->fps_median, entry->mhz_median, entry->ns_per_instruction_median);
+
+    for (int i = 0; i < entry->rep_count; i++) {
+        fprintf(out, "%s%.4f", i ? ", " : "", entry->fps_reps[i]);
+    }
+
+    fprintf(out, "]}\n");
+    fclose(out);
+
+    return true;
+}
+
+// Minimal readers for the flat lines history_append() writes; they are not
+// a general JSON parser.
+
+static const char* find_key(const char* line, const char* key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+
+    const char* at = strstr(line, pattern);
+    return at ? at + strlen(pattern) : NULL;
+}
+
+static bool read_string(const char* line, const char* key, char* out, size_t size) {
+    const char* at = find_key(line, key);
+
+    if (!at || *at != '"') {
+        return false;
+    }
+
+    at++;
+    size_t length = 0;
+    while (at[length] && at[length] != '"' && length + 1 < size) {
+        out[length] = at[length];
+        length++;
+    }
+    out[length] = '\0';
+
+    return true;
+}
+
+static double read_number(const char* line, const char* key) {
+    const char* at = find_key(line, key);
+    return at ? strtod(at, NULL) : 0.0;
+}
+
+static int read_array(const char* line, const char* key, double* out, int max) {
+    const char* at = find_key(line, key);
+
+    if (!at || *at != '[') {
+        return 0;
+    }
+
+    at++;
+    int count = 0;
+
+    while (count < max) {
+        char* end;
+        double value = strtod(at, &end);
+
+        if (end == at) {
+            break;
+        }
+
+        out[count++] = value;
+        at = end;
+
+        while (*at == ',' || *at == ' ') {
+            at++;
+        }
+    }
+
+    return count;
+}
+
+bool history_find(const char* path, const char* commit, const char* backend,
+    const char* flag_engine, int frames, history_entry* out) {
+
+    FILE* in = fopen(path, "r");
+
+    if (!in) {
+        return false;
+    }
+
+    char* line = malloc(HISTORY_MAX_LINE);
+    history_entry* candidate = malloc(sizeof(history_entry));
+    bool found = false;
+    bool any_commit = strcmp(commit, "last") == 0;
+
+    // the file is in run order, so the last match wins
+    while (fgets(line, HISTORY_MAX_LINE, in)) {
+        memset(candidate, 0, sizeof(history_entry));
+
+        if (!read_string(line, "commit", candidate->commit, sizeof(candidate->commit)) ||
+            !read_string(line, "backend", candidate->backend, sizeof(candidate->backend)) ||
+            !read_string(line, "flag_engine", candidate->flag_engine, sizeof(candidate->flag_engine))) {
+            continue;
+        }
+
+        candidate->frames = (int)read_number(line, "frames");
+
+        if ((!any_commit && strncmp(candidate->commit, commit, strlen(commit)) != 0) ||
+            strcmp(candidate->backend, backend) != 0 ||
+            strcmp(candidate->flag_engine, flag_engine) != 0 ||
+            candidate->frames != frames) {
+            continue;
+        }
+
+        read_string(line, "compiler", candidate->compiler, sizeof(candidate->compiler));
+        read_string(line, "flags", candidate->flags, sizeof(candidate->flags));
+        candidate->fps_median = read_number(line, "fps_median");
+        candidate->mhz_median = read_number(line, "emulated_mhz_median");
+        candidate->ns_per_instruction_median = read_number(line, "ns_per_instruction_median");
+        candidate->rep_count = read_array(line, "fps_reps", candidate->fps_reps, HISTORY_MAX_REPS);
+
+        if (candidate->rep_count > 0) {
+            *out = *candidate;
+            found = true;
+        }
+    }
+
+    free(candidate);
+    free(line);
+    fclose(in);
+
+    return found;
+}
+
+typedef struct {
+    double value;
+    int group;
+} ranked_value;
+
+static int compare_ranked(const void* a, const void* b) {
+    double x = ((const ranked_value*)a)->value;
+    double y = ((const ranked_value*)b)->value;
+    return (x > y) - (x < y);
+}
+
+double mann_whitney_p(const double* a, int a_count, const double* b, int b_count) {
+
+    int n = a_count + b_count;
+    ranked_value* values = malloc(sizeof(ranked_value) * n);
+
+    for (int i = 0; i < a_count; i++) {
+        values[i].value = a[i];
+        values[i].group = 0;
+    }
+    for (int i = 0; i < b_count; i++) {
+        values[a_count + i].value = b[i];
+        values[a_count + i].group = 1;
+    }
+
+    qsort(values, n, sizeof(ranked_value), compare_ranked);
+
+    // Sum the ranks of group a, giving tied values their average rank, and
+    // collect the tie term for the variance correction.
+    double rank_sum = 0.0;
+    double tie_term = 0.0;
+
+    for (int i = 0; i < n; ) {
+        int j = i;
+        while (j + 1 < n && values[j + 1].value == values[i].value) {
+            j++;
+        }
+
+        double rank = (i + j) / 2.0 + 1.0;
+        for (int k = i; k <= j; k++) {
+            if (values[k].group == 0) {
+                rank_sum += rank;
+            }
+        }
+
+        double ties = j - i + 1;
+        tie_term += ties * ties * ties - ties;
+
+        i = j + 1;
+    }
+
+    free(values);
+
+    double u = rank_sum - a_count * (a_count + 1) / 2.0;
+    double mean = a_count * (double)b_count / 2.0;
+    double variance = a_count * (double)b_count / 12.0 * ((n + 1) - tie_term / ((double)n * (n - 1)));
+
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+
+    // continuity correction towards the mean
+    double distance = fabs(u - mean) - 0.5;
+    if (distance < 0.0) {
+        distance = 0.0;
+    }
+
+    double z = distance / sqrt(variance);
+    return erfc(z / sqrt(2.0));
+}
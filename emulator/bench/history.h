@@ -0,0 +1,38 @@
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stdbool.h>
+
+// Benchmark result history: one JSON line per benchmark case per run,
+// appended to a local file, plus the statistics used to compare a run
+// against an earlier one.
+
+#define HISTORY_DEFAULT_PATH    "bench_history.jsonl"
+#define HISTORY_MAX_REPS        1000
+
+typedef struct {
+    char commit[48];
+    char compiler[96];
+    char flags[128];
+    char backend[32];
+    char flag_engine[32];
+    int frames;
+    double fps_median;
+    double mhz_median;
+    double ns_per_instruction_median;
+    int rep_count;
+    double fps_reps[HISTORY_MAX_REPS];
+} history_entry;
+
+bool history_append(const char* path, const history_entry* entry);
+
+// Find the most recent entry for the same backend, flag engine and frame
+// count whose commit starts with `commit` ("last" matches any commit).
+bool history_find(const char* path, const char* commit, const char* backend,
+    const char* flag_engine, int frames, history_entry* out);
+
+// Two-sided Mann-Whitney U test (normal approximation with tie correction).
+// Returns the p-value for "a and b come from the same distribution".
+double mann_whitney_p(const double* a, int a_count, const double* b, int b_count);
+
+#endif
@@ -0,0 +1,383 @@
+// microbench - per-opcode micro-benchmark for execute().
+//
+//   ./8080-microbench [--reps N] [--passes N] [--json file] [--perf]
+//
+// For every opcode (and a few opcode classes) this lays out a memory image
+// holding one long straight-line run of that instruction, runs execute()
+// over it and reports host ns per instruction. Conditional jumps, calls and
+// returns are measured twice, once with the flags set so the branch is taken
+// and once so it falls through. --perf adds host IPC, branch mispredicts and
+// L1i/L1d misses per 1000 emulated instructions for each case.
+//
+// Memory layout of every image:
+//   0x0000-0x3fff  the instruction run
+//   0x4000-0xbfff  stack (RET runs pre-fill it with their return addresses)
+//   0xc000-        data that M, LDA/STA, LHLD/SHLD and STAX/LDAX point at
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/cpu.h"
+#include "../src/disasm.h"
+#include "../src/metrics.h"
+#include "../../common/opcodes.h"
+#include "perfctr.h"
+
+#define CODE_END        0x4000
+#define STACK_BOTTOM    0x4000
+#define STACK_TOP       0xc000
+#define DATA_ADDR       0xc000
+
+#define DEFAULT_REPS    7
+#define DEFAULT_PASSES  20
+
+typedef struct {
+    uint8_t memory[0x10000];
+    uint16_t SP;
+    uint16_t HL;
+    uint16_t end;               // PC once the whole run has executed
+    uint32_t count;             // instructions in the run
+    int flags;                  // Z, C, P and S are all set to this
+} bench_image;
+
+typedef struct {
+    const char* name;
+    const uint8_t* ops;
+    int op_count;
+    int flags;
+} opcode_class;
+
+static const uint8_t mov_group[] = {
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75,       0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+};
+
+static const uint8_t alu_group[] = {
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+};
+
+// LXI H keeps HL pointing at the data area between the DADs.
+static const uint8_t wide_group[] = {
+    0x01, 0x03, 0x09, 0x0b, 0x11, 0x13, 0x19, 0x1b, 0x21, 0x23, 0x29, 0x2b, 0x33, 0x39, 0x3b,
+};
+
+// With every flag set, JZ/JC/JPE/JM branch and the second set would not.
+static const uint8_t jcc_set_group[] = { 0xca, 0xda, 0xea, 0xfa };
+
+// Pushes and pops alternate so the stack stays balanced.
+static const uint8_t push_pop_group[] = { 0xc5, 0xc1, 0xd5, 0xd1, 0xe5, 0xe1, 0xf5, 0xf1 };
+
+static const opcode_class classes[] = {
+    { "MOV group",          mov_group,      sizeof(mov_group),      1 },
+    { "ALU group",          alu_group,      sizeof(alu_group),      1 },
+    { "16-bit ops",         wide_group,     sizeof(wide_group),     1 },
+    { "Jcc taken",          jcc_set_group,  sizeof(jcc_set_group),  1 },
+    { "Jcc not taken",      jcc_set_group,  sizeof(jcc_set_group),  0 },
+    { "PUSH/POP",           push_pop_group, sizeof(push_pop_group), 1 },
+};
+
+#define CLASS_COUNT     (int)(sizeof(classes) / sizeof(classes[0]))
+
+static int is_conditional(uint8_t op) {
+    uint8_t group = op & 0xc7;
+    return group == 0xc0 || group == 0xc2 || group == 0xc4;
+}
+
+static int is_branch(uint8_t op) {
+    return is_conditional(op) || op == 0xc3 || op == 0xcb || op == 0xcd ||
+        op == 0xdd || op == 0xed || op == 0xfd;
+}
+
+// The flag value that makes a conditional branch go: Z, C, PE and M (odd
+// condition codes) branch on a set flag, NZ, NC, PO and P on a clear one.
+static int taken_flags(uint8_t op) {
+    return (op >> 3) & 1;
+}
+
+static int is_return(uint8_t op) {
+    return (op & 0xc7) == 0xc0 || op == 0xc9 || op == 0xd9;
+}
+
+// Lay the ops out round-robin over the code area. Jump and call targets are
+// the next instruction so the run stays straight-line whether or not the
+// branch is taken; every other address operand points at the data area.
+static void build_image(bench_image* image, const uint8_t* ops, int op_count, int flags) {
+
+    memset(image->memory, 0, sizeof(image->memory));
+
+    int returns = 0;
+    uint32_t pc = 0;
+    uint32_t count = 0;
+
+    for (int i = 0; ; i++) {
+        uint8_t op = ops[i % op_count];
+        uint8_t length = opcode_table[op].length;
+
+        if (pc + length > CODE_END) {
+            break;
+        }
+
+        image->memory[pc] = op;
+
+        if (length == 3) {
+            uint16_t operand = is_branch(op) ? pc + 3 : DATA_ADDR;
+            image->memory[pc + 1] = operand & 0xff;
+            image->memory[pc + 2] = operand >> 8;
+        }
+
+        pc += length;
+        count++;
+
+        if (is_return(op)) {
+            uint16_t slot = STACK_BOTTOM + 2 * returns++;
+            image->memory[slot] = pc & 0xff;
+            image->memory[slot + 1] = pc >> 8;
+        }
+    }
+
+    image->end = pc;
+    image->count = count;
+    image->flags = flags;
+    image->HL = DATA_ADDR;
+
+    // Returns pop upward from the pre-filled stack, everything else pushes
+    // down from the top of the stack area.
+    image->SP = returns > 0 ? STACK_BOTTOM : STACK_TOP;
+
+    if (op_count == 1 && ops[0] == 0xe9) {
+        // PCHL at 0 jumping to 0: a tight loop of just PCHL
+        image->HL = 0x0000;
+    }
+}
+
+static void reset_cpu(cpu* state, const bench_image* image) {
+
+    memcpy(state->memory, image->memory, sizeof(image->memory));
+
+    state->A = 0x00;
+    state->B = DATA_ADDR >> 8;
+    state->C = DATA_ADDR & 0xff;
+    state->D = DATA_ADDR >> 8;
+    state->E = DATA_ADDR & 0xff;
+    state->H = image->HL >> 8;
+    state->L = image->HL & 0xff;
+    state->SP = image->SP;
+    state->PC = 0x0000;
+
+    // Branch instructions never touch the flags, so whatever we set here
+    // decides taken vs. not taken for the whole run.
+    state->cond.zero = image->flags;
+    state->cond.carry = image->flags;
+    state->cond.parity = image->flags;
+    state->cond.sign = image->flags;
+    state->cond.aux_carry = 0;
+}
+
+typedef struct {
+    double ns;                  // best ns per instruction
+    uint64_t executed;          // instructions run under the counters
+    perf_sample perf;
+} case_result;
+
+static perf_counters perf_storage;
+static perf_counters* perf = NULL;
+
+// Best (lowest) ns per instruction over reps, each timing `passes` runs.
+// Hardware counters, if on, accumulate over every pass.
+static case_result time_image(cpu* state, const bench_image* image, int reps, int passes) {
+
+    case_result result;
+    memset(&result, 0, sizeof(result));
+
+    double best = 0.0;
+
+    for (int r = 0; r < reps; r++) {
+        uint64_t elapsed = 0;
+        uint64_t executed = 0;
+
+        for (int p = 0; p < passes; p++) {
+            reset_cpu(state, image);
+
+            uint64_t before = state->instruction_count;
+
+            if (perf) {
+                perfctr_start(perf);
+            }
+
+            uint64_t start = metrics_now_ns();
+
+            // RST and PCHL loop in place instead of reaching the end, so the
+            // instruction count bounds the run as well
+            for (uint32_t i = 0; i < image->count && state->PC != image->end; i++) {
+                execute(state);
+            }
+
+            elapsed += metrics_now_ns() - start;
+
+            if (perf) {
+                perfctr_stop(perf, &result.perf);
+            }
+
+            executed += state->instruction_count - before;
+        }
+
+        result.executed += executed;
+
+        double ns = (double)elapsed / executed;
+        if (r == 0 || ns < best) {
+            best = ns;
+        }
+    }
+
+    result.ns = best;
+    return result;
+}
+
+static double per_kilo(const case_result* result, perf_counter_id id) {
+    return result->perf.valid[id] ? 1000.0 * result->perf.value[id] / result->executed : 0.0;
+}
+
+static void print_perf(const case_result* result) {
+    double ipc = result->perf.value[PERF_CYCLES] ?
+        (double)result->perf.value[PERF_INSTRUCTIONS] / result->perf.value[PERF_CYCLES] : 0.0;
+
+    printf("%5.2f %8.2f %8.2f %8.2f  ", ipc,
+        per_kilo(result, PERF_BRANCH_MISSES), per_kilo(result, PERF_L1I_MISSES), per_kilo(result, PERF_L1D_MISSES));
+}
+
+static void write_perf(FILE* out, const case_result* result) {
+    if (!perf) {
+        return;
+    }
+
+    double ipc = result->perf.value[PERF_CYCLES] ?
+        (double)result->perf.value[PERF_INSTRUCTIONS] / result->perf.value[PERF_CYCLES] : 0.0;
+
+    fprintf(out, ", \"ipc\": %.4f, \"branch_misses_per_k\": %.4f, \"l1i_misses_per_k\": %.4f, \"l1d_misses_per_k\": %.4f",
+        ipc, per_kilo(result, PERF_BRANCH_MISSES), per_kilo(result, PERF_L1I_MISSES), per_kilo(result, PERF_L1D_MISSES));
+}
+
+static int int_arg(int argc, char** argv, const char* flag, int fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            return atoi(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+static const char* string_arg(int argc, char** argv, const char* flag, const char* fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+int main(int argc, char** argv) {
+
+    int reps = int_arg(argc, argv, "--reps", DEFAULT_REPS);
+    int passes = int_arg(argc, argv, "--passes", DEFAULT_PASSES);
+    const char* json_path = string_arg(argc, argv, "--json", NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            if (perfctr_open(&perf_storage)) {
+                perf = &perf_storage;
+            } else {
+                printf("hardware counters unavailable (perf_event_open failed), continuing without\n");
+            }
+        }
+    }
+
+    if (reps < 1 || passes < 1) {
+        printf("--reps and --passes must be at least 1\n");
+        return 1;
+    }
+
+    cpu* state = init_cpu();
+    bench_image* image = malloc(sizeof(bench_image));
+
+    static case_result taken[256];
+    static case_result not_taken[256];
+
+    printf("op    ns/instr  not-taken  %s instruction\n", perf ? "  ipc  brmis/k   l1i/k    l1d/k  " : "");
+
+    for (int op = 0; op < 256; op++) {
+        uint8_t single = op;
+
+        build_image(image, &single, 1, taken_flags(op));
+        taken[op] = time_image(state, image, reps, passes);
+
+        if (is_conditional(op)) {
+            build_image(image, &single, 1, !taken_flags(op));
+            not_taken[op] = time_image(state, image, reps, passes);
+            printf("%02x    %8.2f   %8.2f  ", op, taken[op].ns, not_taken[op].ns);
+        } else {
+            not_taken[op] = taken[op];
+            printf("%02x    %8.2f   %8s  ", op, taken[op].ns, "");
+        }
+
+        if (perf) {
+            print_perf(&taken[op]);
+        }
+
+        // operand bytes are zero, we only want the mnemonic
+        uint8_t instruction[3] = { op, 0, 0 };
+        disassemble(instruction);
+    }
+
+    case_result class_results[CLASS_COUNT];
+
+    printf("\n%-16s ns/instr  %s\n", "class", perf ? "  ipc  brmis/k   l1i/k    l1d/k" : "");
+
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        build_image(image, classes[c].ops, classes[c].op_count, classes[c].flags);
+        class_results[c] = time_image(state, image, reps, passes);
+        printf("%-16s %8.2f  ", classes[c].name, class_results[c].ns);
+        if (perf) {
+            print_perf(&class_results[c]);
+        }
+        printf("\n");
+    }
+
+    if (json_path) {
+        FILE* json = fopen(json_path, "w");
+
+        if (!json) {
+            printf("could not write %s\n", json_path);
+            return 1;
+        }
+
+        fprintf(json, "{\n  \"reps\": %d,\n  \"passes\": %d,\n  \"opcodes\": [\n", reps, passes);
+        for (int op = 0; op < 256; op++) {
+            fprintf(json, "    {\"op\": %d, \"ns\": %.4f, \"not_taken_ns\": %.4f", op, taken[op].ns, not_taken[op].ns);
+            write_perf(json, &taken[op]);
+            fprintf(json, "}%s\n", op < 255 ? "," : "");
+        }
+        fprintf(json, "  ],\n  \"classes\": [\n");
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            fprintf(json, "    {\"name\": \"%s\", \"ns\": %.4f", classes[c].name, class_results[c].ns);
+            write_perf(json, &class_results[c]);
+            fprintf(json, "}%s\n", c + 1 < CLASS_COUNT ? "," : "");
+        }
+        fprintf(json, "  ]\n}\n");
+        fclose(json);
+    }
+
+    free(image);
+
+    if (perf) {
+        perfctr_close(perf);
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+// syscall() and the perf ioctls are Linux, not C99
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "perfctr.h"
+
+const char* perf_counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "branch_misses", "l1i_misses", "l1d_misses"
+};
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} events[PERF_COUNTER_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1I) },
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+};
+
+static int open_event(int i, int group_fd) {
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = events[i].type;
+    attr.config = events[i].config;
+    attr.disabled = group_fd < 0;     // group members follow their leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+bool perfctr_open(perf_counters* counters) {
+
+    bool any = false;
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        counters->grouped[i] = false;
+
+        // instructions joins the cycles group; if that fails it is left out
+        // rather than counted over a different window
+        if (i == PERF_INSTRUCTIONS) {
+            int leader = counters->fd[PERF_CYCLES];
+
+            counters->fd[i] = leader >= 0 ? open_event(i, leader) : -1;
+            counters->grouped[i] = counters->fd[i] >= 0;
+        } else {
+            counters->fd[i] = open_event(i, -1);
+        }
+
+        if (counters->fd[i] >= 0) {
+            any = true;
+        }
+    }
+
+    return any;
+}
+
+void perfctr_close(perf_counters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fd[i] >= 0) {
+            close(counters->fd[i]);
+            counters->fd[i] = -1;
+        }
+    }
+}
+
+// The cycles counter's ioctls apply to its whole group.
+void perfctr_start(perf_counters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fd[i] >= 0 && !counters->grouped[i]) {
+            ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, i == PERF_CYCLES ? PERF_IOC_FLAG_GROUP : 0);
+            ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, i == PERF_CYCLES ? PERF_IOC_FLAG_GROUP : 0);
+        }
+    }
+}
+
+void perfctr_stop(perf_counters* counters, perf_sample* total) {
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fd[i] >= 0 && !counters->grouped[i]) {
+            ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, i == PERF_CYCLES ? PERF_IOC_FLAG_GROUP : 0);
+        }
+    }
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        // value, time enabled, time running
+        uint64_t data[3];
+
+        if (counters->fd[i] < 0 || read(counters->fd[i], data, sizeof(data)) != sizeof(data)) {
+            continue;
+        }
+
+        // the kernel time-slices counters when there are more than the PMU
+        // has slots; scale up to the whole enabled period
+        if (data[2] != 0 && data[2] < data[1]) {
+            data[0] = (uint64_t)((double)data[0] * data[1] / data[2]);
+        }
+
+        total->value[i] += data[0];
+        total->valid[i] = true;
+    }
+}
+
+#else
+
+bool perfctr_open(perf_counters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        counters->fd[i] = -1;
+        counters->grouped[i] = false;
+    }
+    return false;
+}
+
+void perfctr_close(perf_counters* counters) {
+    (void)counters;
+}
+
+void perfctr_start(perf_counters* counters) {
+    (void)counters;
+}
+
+void perfctr_stop(perf_counters* counters, perf_sample* total) {
+    (void)counters;
+    (void)total;
+}
+
+#endif
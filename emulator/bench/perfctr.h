@@ -0,0 +1,46 @@
+#ifndef _PERFCTR_H
+#define _PERFCTR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Optional host hardware counters for the benchmark harnesses, read through
+// perf_event_open(2). Cycles and instructions are opened as one group led
+// by the cycles counter, so they are always scheduled together and the IPC
+// taken from them covers a single window even when the kernel multiplexes.
+// The other counters are opened on their own, so a CPU or kernel that lacks
+// one (L1i misses are often missing in VMs) still reports the rest. On other
+// platforms, or when perf is locked down, nothing opens and the benchmarks
+// just leave the columns out.
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1I_MISSES,
+    PERF_L1D_MISSES,
+    PERF_COUNTER_COUNT
+} perf_counter_id;
+
+typedef struct {
+    int fd[PERF_COUNTER_COUNT];
+    bool grouped[PERF_COUNTER_COUNT];   // started and stopped with the cycles counter
+} perf_counters;
+
+typedef struct {
+    uint64_t value[PERF_COUNTER_COUNT];
+    bool valid[PERF_COUNTER_COUNT];
+} perf_sample;
+
+extern const char* perf_counter_names[PERF_COUNTER_COUNT];
+
+// Returns true if at least one counter could be opened.
+bool perfctr_open(perf_counters* counters);
+void perfctr_close(perf_counters* counters);
+
+void perfctr_start(perf_counters* counters);
+
+// Stop counting and add the (multiplex-scaled) counts to total.
+void perfctr_stop(perf_counters* counters, perf_sample* total);
+
+#endif
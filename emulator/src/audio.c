@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "audio.h"
+#include "samplebank.h"
+
+// Sound bits, in sample-file order: latch, bit, looping
+typedef struct {
+    uint8_t latch;
+    uint8_t mask;
+    bool loop;
+} sound_bit;
+
+static const sound_bit sound_bits[AUDIO_VOICES] = {
+    { 0, 0x01, true  },     // 0  UFO
+    { 0, 0x02, false },     // 1  shot
+    { 0, 0x04, false },     // 2  player dies
+    { 0, 0x08, false },     // 3  invader dies
+    { 1, 0x01, false },     // 4  fleet step 1
+    { 1, 0x02, false },     // 5  fleet step 2
+    { 1, 0x04, false },     // 6  fleet step 3
+    { 1, 0x08, false },     // 7  fleet step 4
+    { 1, 0x10, false },     // 8  UFO hit
+    { 0, 0x10, false },     // 9  extra life
+};
+
+#define AMP_ENABLE  0x20    // OUT 3 bit 5: sound on (off in attract mode)
+
+typedef struct {
+    bool active;
+    uint32_t position;      // next sample to play
+} voice;
+
+// One frame of output, plus room for the last vector of a voice to run over.
+#define MIX_SIZE    (AUDIO_FRAME_SAMPLES + SAMPLEBANK_PADDING)
+
+bool audio_enabled = false;
+audio_counters audio_stats;
+
+static sample_bank bank;
+static voice voices[AUDIO_VOICES];
+static bool amp_enabled = false;
+static int16_t mix[MIX_SIZE];
+
+// Ring of mono samples. head is only written by audio_frame() on the
+// emulation thread, tail only by audio_read() on the audio thread.
+static int16_t* ring = NULL;
+static uint32_t ring_size = 0;      // a power of two
+static uint32_t ring_limit = 0;     // samples queued at most, <= ring_size
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+
+// out[0..count) += in[0..count), saturating. The vector paths round count up
+// to a whole vector; past the end of a sample that reads the bank's zero
+// padding, and past the end of the frame it lands in the spare room of mix[].
+static void mix_add(int16_t* out, const int16_t* in, uint32_t count) {
+#if defined(__AVX2__)
+    for (uint32_t i = 0; i < count; i += 16) {
+        __m256i sum = _mm256_adds_epi16(_mm256_loadu_si256((const __m256i*)(out + i)),
+            _mm256_loadu_si256((const __m256i*)(in + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), sum);
+    }
+#elif defined(__SSE2__)
+    for (uint32_t i = 0; i < count; i += 8) {
+        __m128i sum = _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out + i)),
+            _mm_loadu_si128((const __m128i*)(in + i)));
+        _mm_storeu_si128((__m128i*)(out + i), sum);
+    }
+#else
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t sum = out[i] + in[i];
+        out[i] = sum > INT16_MAX ? INT16_MAX : sum < INT16_MIN ? INT16_MIN : sum;
+    }
+#endif
+}
+
+bool audio_init(const char* sample_dir, int buffer_ms) {
+
+    if (!samplebank_open(&bank, sample_dir, AUDIO_VOICES, AUDIO_RATE)) {
+        samplebank_close(&bank);
+        return false;
+    }
+
+    if (buffer_ms <= 0) {
+        buffer_ms = AUDIO_DEFAULT_BUFFER_MS;
+    }
+
+    // at least two frames, so one can be mixed while the other plays
+    uint32_t wanted = (uint32_t)((uint64_t)AUDIO_RATE * buffer_ms / 1000);
+
+    if (wanted < 2 * AUDIO_FRAME_SAMPLES) {
+        wanted = 2 * AUDIO_FRAME_SAMPLES;
+    }
+
+    // the storage is a power of two for cheap wrapping, but only `wanted`
+    // samples of it are ever queued so the latency is what was asked for
+    ring_limit = wanted;
+    ring_size = 1;
+    while (ring_size < wanted) {
+        ring_size *= 2;
+    }
+
+    ring = calloc(ring_size, sizeof(int16_t));
+    ring_head = ring_tail = 0;
+    memset(voices, 0, sizeof(voices));
+    memset(&audio_stats, 0, sizeof(audio_stats));
+
+    audio_enabled = true;
+
+    return true;
+}
+
+void audio_close(void) {
+
+    audio_enabled = false;
+
+    samplebank_close(&bank);
+
+    free(ring);
+    ring = NULL;
+}
+
+void audio_latch(int latch, uint8_t previous, uint8_t value) {
+
+    if (!audio_enabled) {
+        return;
+    }
+
+    if (latch == 0) {
+        amp_enabled = value & AMP_ENABLE;
+    }
+
+    uint8_t rising = value & ~previous;
+    uint8_t falling = previous & ~value;
+
+    for (int i = 0; i < AUDIO_VOICES; i++) {
+        const sound_bit* bit = &sound_bits[i];
+
+        if (bit->latch != latch || !bank.samples[i].data) {
+            continue;
+        }
+
+        if (rising & bit->mask) {
+            voices[i].active = true;
+            voices[i].position = 0;
+        } else if (bit->loop && (falling & bit->mask)) {
+            voices[i].active = false;
+        }
+    }
+}
+
+void audio_frame(void) {
+
+    if (!audio_enabled) {
+        return;
+    }
+
+    memset(mix, 0, sizeof(mix));
+
+    for (int i = 0; i < AUDIO_VOICES; i++) {
+        voice* v = &voices[i];
+        const bank_sample* sample = &bank.samples[i];
+        uint32_t n = 0;
+
+        // one run per pass: to the end of the frame or of the sample
+        while (v->active && n < AUDIO_FRAME_SAMPLES) {
+            uint32_t left = sample->length - v->position;
+            uint32_t count = AUDIO_FRAME_SAMPLES - n < left ? AUDIO_FRAME_SAMPLES - n : left;
+
+            mix_add(mix + n, sample->data + v->position, count);
+            n += count;
+            v->position += count;
+
+            if (v->position == sample->length) {
+                v->position = 0;
+                v->active = sound_bits[i].loop;
+            }
+        }
+    }
+
+    if (!amp_enabled) {
+        memset(mix, 0, sizeof(int16_t) * AUDIO_FRAME_SAMPLES);
+    }
+
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    uint32_t room = ring_limit - (head - tail);
+    uint32_t count = room < AUDIO_FRAME_SAMPLES ? room : AUDIO_FRAME_SAMPLES;
+    uint32_t at = head & (ring_size - 1);
+    uint32_t first = ring_size - at < count ? ring_size - at : count;
+
+    memcpy(ring + at, mix, sizeof(int16_t) * first);
+    memcpy(ring, mix + first, sizeof(int16_t) * (count - first));
+
+    __atomic_store_n(&ring_head, head + count, __ATOMIC_RELEASE);
+
+    audio_stats.mixed += count;
+    audio_stats.dropped += AUDIO_FRAME_SAMPLES - count;
+}
+
+size_t audio_read(int16_t* out, size_t count) {
+
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint32_t available = head - tail;
+
+    if (count > available) {
+        count = available;
+    }
+
+    for (size_t n = 0; n < count; n++) {
+        out[n] = ring[(tail + n) & (ring_size - 1)];
+    }
+
+    __atomic_store_n(&ring_tail, tail + (uint32_t)count, __ATOMIC_RELEASE);
+
+    return count;
+}
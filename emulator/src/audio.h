@@ -0,0 +1,54 @@
+#ifndef _AUDIO_H
+#define _AUDIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Space Invaders sound. The cabinet's sound board plays fixed effects
+// switched by bits of OUT 3 and OUT 5; here each bit drives a voice playing a
+// recorded sample (the usual 0.wav..9.wav set). A rising edge starts a
+// voice, and the UFO voice loops until its bit drops.
+//
+// The samples come from an mmap'd bank already at the output rate (see
+// samplebank.h), so mixing is straight saturating adds, 8 or 16 samples at a
+// time with SSE2 or AVX2. The emulation thread mixes one frame's worth of
+// audio after each frame into a single-producer/single-consumer ring, and
+// the SDL audio callback drains it. Neither side ever waits for the other: a
+// full ring drops the newest audio and an empty one plays silence. The frame
+// loop runs off its own 60 Hz clock, so those two cases absorb the drift
+// between it and the audio device. The ring is never filled past the
+// requested depth, which trades latency for safety against underruns.
+
+#define AUDIO_RATE                  44100
+#define AUDIO_FRAME_SAMPLES         (AUDIO_RATE / 60)
+#define AUDIO_VOICES                10
+#define AUDIO_DEFAULT_BUFFER_MS     50
+
+typedef struct {
+    uint64_t mixed;         // samples produced
+    uint64_t dropped;       // samples lost to a full ring
+    uint64_t underruns;     // callbacks that ran out of audio
+} audio_counters;
+
+extern bool audio_enabled;
+extern audio_counters audio_stats;
+
+// Opens the bank for <dir>/0.wav .. 9.wav (missing ones stay silent) and
+// sizes the ring for `buffer_ms` of audio. Returns false if no sample could
+// be loaded.
+bool audio_init(const char* sample_dir, int buffer_ms);
+void audio_close(void);
+
+// Called by the sound latches on every write to OUT 3 (latch 0) or OUT 5
+// (latch 1) with the previous and new values.
+void audio_latch(int latch, uint8_t previous, uint8_t value);
+
+// Producer side: mix AUDIO_FRAME_SAMPLES into the ring.
+void audio_frame(void);
+
+// Consumer side: copy up to `count` mono samples out of the ring and return
+// how many there were.
+size_t audio_read(int16_t* out, size_t count);
+
+#endif
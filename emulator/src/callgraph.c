@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "profile.h"
+
+#ifdef PROFILE_CALLGRAPH
+
+/*
+    Shadow-stack call-graph profiler.
+
+    Every distinct call path gets a node in a tree; the hooks in the CALL/RST
+    and RET helpers walk that tree as the game calls and returns, and
+    execute() charges each instruction's cycles to the current node. Node 0
+    is the code reached from reset; each interrupt vector gets its own root so
+    an ISR is never reported as a callee of whatever it happened to interrupt.
+*/
+
+#define CALLGRAPH_MAX_NODES     65536
+#define CALLGRAPH_MAX_DEPTH     256
+#define CALLGRAPH_TOP_ROUTINES  40
+#define CALLGRAPH_TOP_EDGES     40
+
+callgraph_node callgraph_nodes[CALLGRAPH_MAX_NODES] = {
+    { .addr = 0x0000, .irq = -1, .parent = -1, .first_child = -1, .next_sibling = -1 },
+};
+int callgraph_current = 0;
+
+static int node_count = 1;
+
+typedef struct {
+    int node;
+    uint16_t return_addr;
+} shadow_frame;
+
+static shadow_frame shadow_stack[CALLGRAPH_MAX_DEPTH];
+static int shadow_depth = 0;
+
+// Set by callgraph_interrupt(), consumed by the RST it precedes.
+static int pending_irq = -1;
+
+// Root node of each interrupt vector, 0 until its first interrupt (node 0 is
+// the reset root, never an interrupt's).
+static int irq_root[8];
+
+static uint64_t depth_overflows = 0;
+static uint64_t unmatched_returns = 0;
+
+static int new_node(uint16_t addr, int8_t irq, int parent) {
+    if (node_count == CALLGRAPH_MAX_NODES) {
+        return -1;
+    }
+
+    callgraph_node* node = &callgraph_nodes[node_count];
+    node->addr = addr;
+    node->irq = irq;
+    node->parent = parent;
+    node->first_child = -1;
+    node->next_sibling = parent >= 0 ? callgraph_nodes[parent].first_child : -1;
+
+    if (parent >= 0) {
+        callgraph_nodes[parent].first_child = node_count;
+    }
+
+    return node_count++;
+}
+
+static int find_child(int parent, uint16_t addr) {
+    for (int i = callgraph_nodes[parent].first_child; i != -1; i = callgraph_nodes[i].next_sibling) {
+        if (callgraph_nodes[i].addr == addr) {
+            return i;
+        }
+    }
+
+    int node = new_node(addr, -1, parent);
+    return node == -1 ? parent : node;
+}
+
+static int find_irq_root(uint8_t interrupt_num, uint16_t addr) {
+    int* root = &irq_root[interrupt_num & 7];
+
+    if (!*root) {
+        int node = new_node(addr, interrupt_num, -1);
+
+        if (node == -1) {
+            return callgraph_current;
+        }
+        *root = node;
+    }
+
+    return *root;
+}
+
+void callgraph_interrupt(uint8_t interrupt_num) {
+    pending_irq = interrupt_num;
+}
+
+// Called with the return address already pushed and PC not yet changed.
+void callgraph_call(cpu* state, uint16_t target) {
+
+    if (shadow_depth == CALLGRAPH_MAX_DEPTH) {
+        depth_overflows++;
+        pending_irq = -1;
+        return;
+    }
+
+    int node;
+
+    if (pending_irq >= 0) {
+        node = find_irq_root(pending_irq, target);
+        pending_irq = -1;
+    } else {
+        node = find_child(callgraph_current, target);
+    }
+
+    callgraph_nodes[node].calls++;
+
+    shadow_stack[shadow_depth].node = callgraph_current;
+    shadow_stack[shadow_depth].return_addr = state->PC;
+    shadow_depth++;
+
+    callgraph_current = node;
+}
+
+// Called after a taken RET has loaded PC. The game occasionally drops or
+// rewrites return addresses on the 8080 stack, so unwind to the frame whose
+// return address matches rather than blindly popping one.
+void callgraph_ret(cpu* state) {
+    for (int i = shadow_depth - 1; i >= 0; i--) {
+        if (shadow_stack[i].return_addr == state->PC) {
+            callgraph_current = shadow_stack[i].node;
+            shadow_depth = i;
+            return;
+        }
+    }
+
+    unmatched_returns++;
+}
+
+static const char* node_label(int node, char* buffer) {
+    if (callgraph_nodes[node].irq >= 0) {
+        sprintf(buffer, "irq%d", callgraph_nodes[node].irq);
+    } else if (callgraph_nodes[node].parent == -1) {
+        sprintf(buffer, "reset");
+    } else {
+        sprintf(buffer, "sub_%04x", callgraph_nodes[node].addr);
+    }
+    return buffer;
+}
+
+static void write_folded(const char* path) {
+
+    FILE* out = fopen(path, "w");
+
+    if (!out) {
+        fprintf(stderr, "could not write %s\n", path);
+        return;
+    }
+
+    // the tree is never deeper than the shadow stack plus its root
+    int path_nodes[CALLGRAPH_MAX_DEPTH + 1];
+    char label[16];
+
+    for (int i = 0; i < node_count; i++) {
+        if (callgraph_nodes[i].self_cycles == 0) {
+            continue;
+        }
+
+        int depth = 0;
+        for (int n = i; n != -1; n = callgraph_nodes[n].parent) {
+            path_nodes[depth++] = n;
+        }
+
+        for (int d = depth - 1; d >= 0; d--) {
+            fprintf(out, "%s%s", node_label(path_nodes[d], label), d ? ";" : "");
+        }
+
+        fprintf(out, " %llu\n", (unsigned long long)callgraph_nodes[i].self_cycles);
+    }
+
+    fclose(out);
+}
+
+typedef struct {
+    uint16_t addr;
+    uint64_t calls;
+    uint64_t inclusive;
+    uint64_t exclusive;
+} routine_total;
+
+typedef struct {
+    int from;               // caller node (label source)
+    uint16_t to;
+    uint64_t calls;
+} edge_total;
+
+static int compare_routines(const void* a, const void* b) {
+    uint64_t x = ((const routine_total*)a)->inclusive;
+    uint64_t y = ((const routine_total*)b)->inclusive;
+    return (x < y) - (x > y);
+}
+
+// Collapse the caller side of an edge to its routine: the irq/reset roots
+// keep their own identity, everything else is keyed by entry address.
+static int edge_key(int node) {
+    if (callgraph_nodes[node].irq >= 0) {
+        return 0x10000 + callgraph_nodes[node].irq;
+    }
+    if (callgraph_nodes[node].parent == -1) {
+        return -1;
+    }
+    return callgraph_nodes[node].addr;
+}
+
+static int compare_edge_keys(const void* a, const void* b) {
+    const edge_total* x = a;
+    const edge_total* y = b;
+    int kx = edge_key(x->from);
+    int ky = edge_key(y->from);
+    if (kx != ky) {
+        return kx < ky ? -1 : 1;
+    }
+    return (int)x->to - (int)y->to;
+}
+
+static int compare_edge_calls(const void* a, const void* b) {
+    uint64_t x = ((const edge_total*)a)->calls;
+    uint64_t y = ((const edge_total*)b)->calls;
+    return (x < y) - (x > y);
+}
+
+void callgraph_report(const char* folded_path) {
+
+    uint64_t* subtree = calloc(node_count, sizeof(uint64_t));
+
+    // Children are always created after their parent, so one backwards pass
+    // accumulates every subtree total.
+    for (int i = node_count - 1; i >= 0; i--) {
+        subtree[i] += callgraph_nodes[i].self_cycles;
+        if (callgraph_nodes[i].parent >= 0) {
+            subtree[callgraph_nodes[i].parent] += subtree[i];
+        }
+    }
+
+    routine_total* routines = calloc(0x10000, sizeof(routine_total));
+
+    for (int i = 0; i < node_count; i++) {
+        callgraph_node* node = &callgraph_nodes[i];
+
+        if (node->parent == -1) {
+            continue;
+        }
+
+        routine_total* r = &routines[node->addr];
+        r->addr = node->addr;
+        r->calls += node->calls;
+        r->exclusive += node->self_cycles;
+
+        // Only the outermost activation of a recursive routine counts toward
+        // its inclusive time, otherwise the nested cycles are counted twice.
+        int recursive = 0;
+        for (int p = node->parent; p != -1; p = callgraph_nodes[p].parent) {
+            if (callgraph_nodes[p].parent != -1 && callgraph_nodes[p].addr == node->addr) {
+                recursive = 1;
+                break;
+            }
+        }
+
+        if (!recursive) {
+            r->inclusive += subtree[i];
+        }
+    }
+
+    qsort(routines, 0x10000, sizeof(routine_total), compare_routines);
+
+    printf("\n--- call graph: %d paths, %llu unmatched returns, %llu depth overflows ---\n",
+        node_count, (unsigned long long)unmatched_returns, (unsigned long long)depth_overflows);
+
+    char label[16];
+
+    printf("\nroot   %16s\n", "cycles");
+    for (int i = 0; i < node_count; i++) {
+        if (callgraph_nodes[i].parent == -1) {
+            printf("%-6s %16llu\n", node_label(i, label), (unsigned long long)subtree[i]);
+        }
+    }
+
+    printf("\nroutine   %10s %16s %16s\n", "calls", "inclusive", "exclusive");
+    for (int i = 0; i < CALLGRAPH_TOP_ROUTINES && routines[i].inclusive; i++) {
+        printf("sub_%04x  %10llu %16llu %16llu\n", routines[i].addr,
+            (unsigned long long)routines[i].calls,
+            (unsigned long long)routines[i].inclusive,
+            (unsigned long long)routines[i].exclusive);
+    }
+
+    edge_total* edges = malloc(sizeof(edge_total) * node_count);
+    int edge_count = 0;
+
+    for (int i = 0; i < node_count; i++) {
+        if (callgraph_nodes[i].parent == -1) {
+            continue;
+        }
+        edges[edge_count].from = callgraph_nodes[i].parent;
+        edges[edge_count].to = callgraph_nodes[i].addr;
+        edges[edge_count].calls = callgraph_nodes[i].calls;
+        edge_count++;
+    }
+
+    qsort(edges, edge_count, sizeof(edge_total), compare_edge_keys);
+
+    int merged = 0;
+    for (int i = 0; i < edge_count; i++) {
+        if (merged > 0 && compare_edge_keys(&edges[merged - 1], &edges[i]) == 0) {
+            edges[merged - 1].calls += edges[i].calls;
+        } else {
+            edges[merged++] = edges[i];
+        }
+    }
+
+    qsort(edges, merged, sizeof(edge_total), compare_edge_calls);
+
+    printf("\n%-10s    %-10s %10s\n", "caller", "callee", "calls");
+    for (int i = 0; i < merged && i < CALLGRAPH_TOP_EDGES; i++) {
+        printf("%-10s -> sub_%04x   %10llu\n", node_label(edges[i].from, label),
+            edges[i].to, (unsigned long long)edges[i].calls);
+    }
+
+    write_folded(folded_path);
+    printf("\nfolded stacks written to %s\n", folded_path);
+
+    free(edges);
+    free(routines);
+    free(subtree);
+}
+
+#endif
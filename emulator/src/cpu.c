@@ -6,6 +6,12 @@
 
 #include "cpu.h"
 #include "disasm.h"
+#include "profile.h"
+#include "sampler.h"
+#include "timeline.h"
+#include "io.h"
+
+bool trace_instructions = false;
 
 // Scratch buffer used by dump_registers() to lay out register bytes for printing.
 static uint8_t* register_array = NULL;
@@ -116,6 +122,18 @@ static void CMP(cpu* state, uint8_t operand) {
     state->cond.parity = calculate_parity((state->A - operand));
 }
 
+// Every taken CALL/RST and RET funnels through these so the profilers can
+// keep their shadow call stacks in step with the 8080 stack.
+static inline void on_call(cpu* state, uint16_t target) {
+    PROFILE_CALL(state, target);
+    SAMPLER_CALL(state, target);
+}
+
+static inline void on_ret(cpu* state) {
+    PROFILE_RET(state);
+    SAMPLER_RET(state);
+}
+
 static void PUSH(cpu* state, uint8_t reg1, uint8_t reg2, uint8_t push_psw) {
     //technically the stack is decremented after the operation but makes no difference here really
     state->SP -= 2;
@@ -223,6 +241,7 @@ static void CALL(cpu* state, uint8_t high, uint8_t low) {
     state->memory[state->SP] = state->PC;
     state->memory[state->SP + 1] = state->PC >> 8;
 
+    on_call(state, (high << 8) | low);
     state->PC = ((high << 8) | low);
 }
 
@@ -232,6 +251,7 @@ static void CC(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -242,6 +262,7 @@ static void CNC(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -252,6 +273,7 @@ static void CZ(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -262,6 +284,7 @@ static void CNZ(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -272,6 +295,7 @@ static void CM(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -282,6 +306,7 @@ static void CP(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -292,6 +317,7 @@ static void CPE(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -302,6 +328,7 @@ static void CPO(cpu* state, uint8_t high, uint8_t low) {
         state->SP -= 2;
         state->memory[state->SP] = state->PC;
         state->memory[state->SP + 1] = state->PC >> 8;
+        on_call(state, (high << 8) | low);
         state->PC = ((high << 8) | low);
     }
 }
@@ -310,6 +337,7 @@ static void CPO(cpu* state, uint8_t high, uint8_t low) {
 static void RET(cpu* state) {
     state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
     state->SP += 2;
+    on_ret(state);
 }
 
 // RC - Return if Carry
@@ -317,6 +345,7 @@ static void RC(cpu* state) {
     if (state->cond.carry == 1) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -325,6 +354,7 @@ static void RNC(cpu* state) {
     if (state->cond.carry == 0) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -333,6 +363,7 @@ static void RZ(cpu* state) {
     if (state->cond.zero == 1) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -341,6 +372,7 @@ static void RNZ(cpu* state) {
     if (state->cond.zero == 0) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -349,6 +381,7 @@ static void RM(cpu* state) {
     if (state->cond.sign == 1) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -357,6 +390,7 @@ static void RP(cpu* state) {
     if (state->cond.sign == 0) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -365,6 +399,7 @@ static void RPE(cpu* state) {
     if (state->cond.parity == 1) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -373,6 +408,7 @@ static void RPO(cpu* state) {
     if (state->cond.parity == 0) {
         state->PC = (state->memory[state->SP+1] << 8) | state->memory[state->SP];
         state->SP += 2;
+        on_ret(state);
     }
 }
 
@@ -384,6 +420,7 @@ static void RST(cpu* state, uint8_t offset) {
     state->memory[state->SP] = state->PC;
     state->memory[state->SP + 1] = state->PC >> 8;
 
+    on_call(state, offset);
     state->PC = offset;
 }
 
@@ -397,6 +434,10 @@ static void EI(cpu* state) {
     state->interrupt_flag.INTE = 1;
 }
 
+static const char* interrupt_names[8] = {
+    "RST 0", "RST 1", "RST 2", "RST 3", "RST 4", "RST 5", "RST 6", "RST 7"
+};
+
 // generate_interrupt - emulates the display hardware asserting an interrupt line.
 // The frame loop calls this twice per frame: RST 1 at mid-screen, RST 2 at VBlank.
 void generate_interrupt(cpu* state, uint8_t interrupt_num) {
@@ -404,6 +445,11 @@ void generate_interrupt(cpu* state, uint8_t interrupt_num) {
     // When enabled: clear INTE first (the 8080 blocks further interrupts until the
     // ISR re-enables them with EI), then perform an RST to the interrupt vector.
     // Recall RST n jumps to address n * 8 — and you already have an RST() helper.
+    if (timeline_enabled) {
+        timeline_instant(interrupt_names[interrupt_num & 7], state->cycle_count);
+    }
+
+    PROFILE_INTERRUPT(interrupt_num);
     RST(state, interrupt_num * 8);
 }
 
@@ -644,37 +690,23 @@ static void SPHL(cpu* state) {
     state->SP = (state->H << 8) | state->L;
 }
 
-static void disassemble_instruction(uint8_t* instruction) {
-    disassemble(instruction);
-}
-
-// Number of clock cycles (states) each opcode takes, indexed by the opcode byte.
-// For the conditional CALL/RET opcodes this holds the *branch-not-taken* cost;
-// add 6 more cycles when the branch is actually taken (not yet accounted for).
+// Number of clock cycles (states) each opcode takes, indexed by the opcode byte,
+// from the shared opcode table. Conditional CALL/RET are always charged their
+// not-taken cost here, even when taken; the table's taken column (6 cycles
+// more) is only used by the disassembler's block timings.
 static const uint8_t cycles8080[256] = {
-//  x0  x1  x2  x3  x4  x5  x6  x7  x8  x9  xa  xb  xc  xd  xe  xf
-     4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, // 0x
-     4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, // 1x
-     4, 10, 16,  5,  5,  5,  7,  4,  4, 10, 16,  5,  5,  5,  7,  4, // 2x
-     4, 10, 13,  5, 10, 10, 10,  4,  4, 10, 13,  5,  5,  5,  7,  4, // 3x
-     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 4x
-     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 5x
-     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 6x
-     7,  7,  7,  7,  7,  7,  7,  7,  5,  5,  5,  5,  5,  5,  7,  5, // 7x
-     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 8x
-     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 9x
-     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // ax
-     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // bx
-     5, 10, 10, 10, 11, 11,  7, 11,  5, 10, 10, 10, 11, 17,  7, 11, // cx
-     5, 10, 10, 10, 11, 11,  7, 11,  5, 10, 10, 10, 11, 17,  7, 11, // dx
-     5, 10, 10, 18, 11, 11,  7, 11,  5,  5, 10,  5, 11, 17,  7, 11, // ex
-     5, 10, 10,  4, 11, 11,  7, 11,  5,  5, 10,  4, 11, 17,  7, 11, // fx
+#define OPCODE(code, mnemonic, registers, operand, length, cycles, taken, flags, flow) [code] = cycles,
+#include "../../common/opcodes.def"
+#undef OPCODE
 };
 
 void execute(cpu* state) {
     
     uint8_t* instruction = &state->memory[state->PC];
-    disassemble_instruction(instruction);
+
+    if (trace_instructions) {
+        trace_instruction(state->PC, instruction);
+    }
     
     uint16_t memory_offset;
     state->PC++; //increment the Program Counter after every instruction
@@ -683,6 +715,10 @@ void execute(cpu* state) {
     uint8_t addr_high = 0;
 
     state->total_cpu_cycles = state->total_cpu_cycles + cycles8080[*instruction];
+    state->cycle_count += cycles8080[*instruction];
+    state->instruction_count++;
+    PROFILE_INSTRUCTION(state->PC - 1, cycles8080[*instruction]);
+    SAMPLER_TICK(state->PC - 1, cycles8080[*instruction]);
 
     switch(*instruction) {
         case 0x00:
@@ -1504,6 +1540,11 @@ void execute(cpu* state) {
             state->PC += 2;
             JNC(state, addr_high, addr_low);
             break;
+        case 0xD3:
+            // OUT port
+            port_write[instruction[1]](instruction[1], state->A);
+            state->PC += 1;
+            break;
         case 0xD4:
             addr_low = state->memory[state->PC];
             addr_high = state->memory[state->PC+1];
@@ -1531,6 +1572,11 @@ void execute(cpu* state) {
             state->PC += 2;
             JC(state, addr_high, addr_low);
             break;
+        case 0xDB:
+            // IN port
+            state->A = port_read[instruction[1]](instruction[1]);
+            state->PC += 1;
+            break;
         case 0xDC:
             addr_low = state->memory[state->PC];
             addr_high = state->memory[state->PC+1];
@@ -1738,6 +1784,10 @@ cpu* init_cpu(void) {
     state->cond.sign = 0;
     state->cond.zero = 0;
 
+    state->total_cpu_cycles = 0;
+    state->instruction_count = 0;
+    state->cycle_count = 0;
+
     return state;
 }
 
@@ -2,6 +2,7 @@
 #define _CPU_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define PSW_FLAG        1
 
@@ -42,10 +43,18 @@ struct cpu {
     flags cond;
 
     uint32_t total_cpu_cycles;
+
+    // Running totals since init_cpu(); unlike total_cpu_cycles these are
+    // never reset by the frame loop.
+    uint64_t instruction_count;
+    uint64_t cycle_count;
 };
 
 typedef struct cpu cpu;
 
+// When set, execute() prints every instruction through disassemble().
+extern bool trace_instructions;
+
 uint8_t calculate_parity(uint8_t value);
 
 cpu* init_cpu(void);
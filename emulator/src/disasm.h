@@ -1,6 +1,18 @@
 #ifndef _DISASM_H
 #define _DISASM_H
 
+#include <stdint.h>
+
+#include "../../common/symbols.h"
+
 void disassemble(uint8_t* operation);
 
-#endif
\ No newline at end of file
+// Prints "addr  instruction" for --trace, preceded by a "name:" line when
+// the address has a symbol.
+void trace_instruction(uint16_t pc, uint8_t* operation);
+
+// Print symbol names instead of 16-bit operands and traced addresses; NULL
+// turns it off.
+void disassemble_use_symbols(const symbol_table* table);
+
+#endif
@@ -2,19 +2,45 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
 
 #include "display.h"
+#include "metrics.h"
+#include "timeline.h"
+#include "audio.h"
+#include "invaders.h"
 
 bool running = NULL;
 
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
 SDL_Texture* texture = NULL;
+SDL_AudioDeviceID audio_device = 0;
 
 uint32_t* frame_buffer;
 
+// Scancode -> INPUT_* bits. Filled once from the defaults or --keymap, so
+// handling a key is one table lookup.
+static uint16_t key_inputs[SDL_NUM_SCANCODES];
+
+static const struct {
+    SDL_Scancode key;
+    uint16_t input;
+} default_keys[] = {
+    { SDL_SCANCODE_C, INPUT_COIN },
+    { SDL_SCANCODE_1, INPUT_P1_START },
+    { SDL_SCANCODE_2, INPUT_P2_START },
+    { SDL_SCANCODE_SPACE, INPUT_P1_FIRE },
+    { SDL_SCANCODE_LEFT, INPUT_P1_LEFT },
+    { SDL_SCANCODE_RIGHT, INPUT_P1_RIGHT },
+    { SDL_SCANCODE_W, INPUT_P2_FIRE },
+    { SDL_SCANCODE_A, INPUT_P2_LEFT },
+    { SDL_SCANCODE_D, INPUT_P2_RIGHT },
+    { SDL_SCANCODE_T, INPUT_TILT },
+};
+
 bool init_window(void) {
 
     if (SDL_InitSubSystem(SDL_INIT_EVERYTHING) != 0) {
@@ -78,14 +104,124 @@ void render_framebuffer(void) {
     SDL_RenderPresent(renderer);
 }
 
+void default_keymap(void) {
+    memset(key_inputs, 0, sizeof(key_inputs));
+
+    for (size_t i = 0; i < sizeof(default_keys) / sizeof(default_keys[0]); i++) {
+        key_inputs[default_keys[i].key] |= default_keys[i].input;
+    }
+}
+
+bool load_keymap(const char* path) {
+
+    FILE* file = fopen(path, "r");
+
+    if (!file) {
+        fprintf(stderr, "could not open keymap %s\n", path);
+        return false;
+    }
+
+    char line[128];
+    int line_number = 0;
+
+    memset(key_inputs, 0, sizeof(key_inputs));
+
+    while (fgets(line, sizeof(line), file)) {
+        char control[32];
+        char key[64];
+
+        line_number++;
+
+        // "<control> <SDL key name>", the key name may contain spaces
+        if (line[0] == '#' || sscanf(line, "%31s %63[^\r\n]", control, key) != 2) {
+            continue;
+        }
+
+        uint16_t input = invaders_input_named(control);
+        SDL_Scancode scancode = SDL_GetScancodeFromName(key);
+
+        if (!input || scancode == SDL_SCANCODE_UNKNOWN) {
+            fprintf(stderr, "%s:%d: unknown control or key\n", path, line_number);
+            continue;
+        }
+
+        key_inputs[scancode] |= input;
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+// Drains every pending event, so nothing queues up between frames, and
+// latches the controls for the IN ports. A control pressed at any point
+// since the last call reads as held until the next one, so a tap shorter
+// than a frame still reaches the game.
 void process_input(void) {
+    static uint16_t held = 0;
+    uint16_t pressed = 0;
     SDL_Event event;
-    SDL_PollEvent(&event);
 
-    switch(event.type) {
-        case SDL_QUIT:
-            running = false;
-            break;
+    while (SDL_PollEvent(&event)) {
+        switch(event.type) {
+            case SDL_QUIT:
+                running = false;
+                break;
+            case SDL_KEYDOWN:
+                held |= key_inputs[event.key.keysym.scancode];
+                pressed |= key_inputs[event.key.keysym.scancode];
+                break;
+            case SDL_KEYUP:
+                held &= ~key_inputs[event.key.keysym.scancode];
+                break;
+        }
+    }
+
+    invaders_input_latch = held | pressed;
+}
+
+// Runs on SDL's audio thread. Whatever the ring can't supply is silence.
+static void audio_callback(void* userdata, Uint8* stream, int len) {
+    (void)userdata;
+
+    int16_t* out = (int16_t*)stream;
+    size_t wanted = len / sizeof(int16_t);
+    size_t got = audio_read(out, wanted);
+
+    if (got < wanted) {
+        memset(out + got, 0, (wanted - got) * sizeof(int16_t));
+        __atomic_fetch_add(&audio_stats.underruns, 1, __ATOMIC_RELAXED);
+    }
+}
+
+bool init_audio(void) {
+
+    SDL_AudioSpec want;
+    SDL_AudioSpec have;
+
+    SDL_zero(want);
+    want.freq = AUDIO_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = 512;
+    want.callback = audio_callback;
+
+    audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+
+    if (!audio_device) {
+        fprintf(stderr, "could not open audio: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_PauseAudioDevice(audio_device, 0);
+
+    return true;
+}
+
+void destroy_audio(void) {
+    if (audio_device) {
+        SDL_CloseAudioDevice(audio_device);
+        audio_device = 0;
     }
 }
 
@@ -109,6 +245,10 @@ void draw_pixel(uint32_t posX, uint32_t posY, uint32_t colour) {
 }
 
 void render(cpu* state) {
+    uint64_t render_start = timeline_begin();
+
+    metrics_phase_begin(PHASE_RENDER);
+
     clear_framebuffer();
 
     uint16_t vid_mem_index = 0x2400;
@@ -123,5 +263,13 @@ void render(cpu* state) {
         }
     }
 
+    metrics_phase_end(PHASE_RENDER);
+
+    metrics_phase_begin(PHASE_PRESENT);
+    uint64_t present_start = timeline_begin();
     render_framebuffer();
+    timeline_end("render_framebuffer", present_start, state->cycle_count);
+    metrics_phase_end(PHASE_PRESENT);
+
+    timeline_end("render", render_start, state->cycle_count);
 }
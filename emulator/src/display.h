@@ -25,7 +25,18 @@ bool init_window(void);
 void clear_framebuffer(void);
 void render_framebuffer(void);
 void process_input(void);
+
+// Which keys drive which cabinet controls. The keymap file has one
+// "<control> <SDL key name>" pair per line, e.g. "p1_fire Space"; controls
+// are coin, p1_start, p2_start, p1_fire, p1_left, p1_right, p2_fire,
+// p2_left, p2_right and tilt.
+void default_keymap(void);
+bool load_keymap(const char* path);
 void destroy_window(void);
+
+// Opens the SDL audio device, fed from the audio ring (see audio.h).
+bool init_audio(void);
+void destroy_audio(void);
 void quit(void);
 void draw_pixel(uint32_t posX, uint32_t posY, uint32_t colour);
 void render(cpu* state);
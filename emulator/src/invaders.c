@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "invaders.h"
+#include "io.h"
+#include "audio.h"
+
+uint16_t invaders_input_latch;
+uint8_t invaders_dip;
+
+static void (*input_poll)(void) = NULL;
+static bool input_current = false;
+uint8_t invaders_sound[2];
+
+// OUT 4 shifts a byte in from the top; IN 3 reads 8 bits starting
+// shift_amount bits below the top.
+static uint16_t shift_value;
+static uint8_t shift_amount;
+
+static const struct {
+    const char* name;
+    uint16_t bit;
+} input_names[] = {
+    { "coin", INPUT_COIN },
+    { "p1_start", INPUT_P1_START },
+    { "p2_start", INPUT_P2_START },
+    { "p1_fire", INPUT_P1_FIRE },
+    { "p1_left", INPUT_P1_LEFT },
+    { "p1_right", INPUT_P1_RIGHT },
+    { "p2_fire", INPUT_P2_FIRE },
+    { "p2_left", INPUT_P2_LEFT },
+    { "p2_right", INPUT_P2_RIGHT },
+    { "tilt", INPUT_TILT },
+};
+
+uint16_t invaders_input_named(const char* name) {
+    for (size_t i = 0; i < sizeof(input_names) / sizeof(input_names[0]); i++) {
+        if (strcmp(input_names[i].name, name) == 0) {
+            return input_names[i].bit;
+        }
+    }
+    return 0;
+}
+
+void invaders_set_input_poll(void (*poll)(void)) {
+    input_poll = poll;
+    input_current = false;
+}
+
+void invaders_expire_input(void) {
+    input_current = false;
+}
+
+void invaders_sample_input(void) {
+    if (!input_current && input_poll) {
+        input_poll();
+        input_current = true;
+    }
+}
+
+static uint8_t read_inputs(uint8_t port) {
+    (void)port;
+    return 0x0E;
+}
+
+// bit 3 is wired high
+static uint8_t read_player1(uint8_t port) {
+    (void)port;
+    invaders_sample_input();
+    return (invaders_input_latch & 0x77) | 0x08;
+}
+
+static uint8_t read_player2(uint8_t port) {
+    (void)port;
+    invaders_sample_input();
+    return ((invaders_input_latch >> 8) & 0x74) | (invaders_dip & 0x8B);
+}
+
+static uint8_t read_shift(uint8_t port) {
+    (void)port;
+    return (shift_value >> (8 - shift_amount)) & 0xFF;
+}
+
+static void write_shift_amount(uint8_t port, uint8_t value) {
+    (void)port;
+    shift_amount = value & 0x07;
+}
+
+static void write_shift_data(uint8_t port, uint8_t value) {
+    (void)port;
+    shift_value = (value << 8) | (shift_value >> 8);
+}
+
+static void write_sound(uint8_t port, uint8_t value) {
+    int latch = port == INVADERS_PORT_SOUND2;
+
+    audio_latch(latch, invaders_sound[latch], value);
+    invaders_sound[latch] = value;
+}
+
+void invaders_attach(void) {
+
+    shift_value = 0;
+    shift_amount = 0;
+
+    invaders_input_latch = 0;
+    input_current = false;
+    invaders_dip = 0x00;    // 3 ships, bonus at 1500
+
+    invaders_sound[0] = 0;
+    invaders_sound[1] = 0;
+
+    io_register_read(INVADERS_PORT_INPUTS, read_inputs);
+    io_register_read(INVADERS_PORT_PLAYER1, read_player1);
+    io_register_read(INVADERS_PORT_PLAYER2, read_player2);
+    io_register_read(INVADERS_PORT_SHIFT_IN, read_shift);
+
+    io_register_write(INVADERS_PORT_SHIFT_AMOUNT, write_shift_amount);
+    io_register_write(INVADERS_PORT_SOUND1, write_sound);
+    io_register_write(INVADERS_PORT_SHIFT_DATA, write_shift_data);
+    io_register_write(INVADERS_PORT_SOUND2, write_sound);
+}
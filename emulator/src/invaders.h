@@ -0,0 +1,67 @@
+#ifndef _INVADERS_H
+#define _INVADERS_H
+
+#include <stdint.h>
+
+// Space Invaders cabinet I/O: the 16-bit hardware shift register the game
+// uses to draw sprites at any pixel offset, the input ports and the sound
+// latches.
+//
+//   IN  0  inputs (unused by the game)    OUT 2  shift amount (bits 0-2)
+//   IN  1  player 1 / coin / start        OUT 3  sound latch 1
+//   IN  2  player 2 / DIP switches        OUT 4  shift data
+//   IN  3  shift register result          OUT 5  sound latch 2
+//                                         OUT 6  watchdog (ignored)
+
+#define INVADERS_PORT_INPUTS    0
+#define INVADERS_PORT_PLAYER1   1
+#define INVADERS_PORT_PLAYER2   2
+#define INVADERS_PORT_SHIFT_IN  3
+
+#define INVADERS_PORT_SHIFT_AMOUNT  2
+#define INVADERS_PORT_SOUND1        3
+#define INVADERS_PORT_SHIFT_DATA    4
+#define INVADERS_PORT_SOUND2        5
+#define INVADERS_PORT_WATCHDOG      6
+
+// Cabinet controls, one bit each in invaders_input_latch. The low byte
+// lines up with IN 1 and the high byte with IN 2, so the port handlers only
+// mask and merge.
+#define INPUT_COIN          0x0001
+#define INPUT_P2_START      0x0002
+#define INPUT_P1_START      0x0004
+#define INPUT_P1_FIRE       0x0010
+#define INPUT_P1_LEFT       0x0020
+#define INPUT_P1_RIGHT      0x0040
+#define INPUT_TILT          0x0400
+#define INPUT_P2_FIRE       0x1000
+#define INPUT_P2_LEFT       0x2000
+#define INPUT_P2_RIGHT      0x4000
+
+// Controls held right now, written by the front end and read by IN 1 / IN 2.
+extern uint16_t invaders_input_latch;
+
+// DIP switches on IN 2: bits 0-1 extra ships, bit 3 bonus at 1000, bit 7
+// coin info off.
+extern uint8_t invaders_dip;
+
+// Late input sampling. Instead of the front end polling at the top of each
+// frame, it registers its poll function here and the latch is refreshed on
+// demand: by the first IN 1 / IN 2 after the latch expires, or by the
+// machine just before the VBlank interrupt if the game hasn't asked yet.
+// run_frame() expires the latch at each interrupt, so the game sees input
+// at most half a frame old instead of up to a frame.
+void invaders_set_input_poll(void (*poll)(void));
+void invaders_expire_input(void);
+void invaders_sample_input(void);
+
+// The INPUT_* bit for a control name ("coin", "p1_fire", ...), 0 if unknown.
+uint16_t invaders_input_named(const char* name);
+
+// Last values written to OUT 3 and OUT 5.
+extern uint8_t invaders_sound[2];
+
+// Resets the devices and registers their handlers in the port tables.
+void invaders_attach(void);
+
+#endif
@@ -0,0 +1,35 @@
+#include <stdint.h>
+
+#include "io.h"
+
+static uint8_t unmapped_read(uint8_t port) {
+    (void)port;
+    return 0;
+}
+
+static void unmapped_write(uint8_t port, uint8_t value) {
+    (void)port;
+    (void)value;
+}
+
+// Filled at compile time, so IN and OUT are safe before io_reset() runs.
+#define REPEAT_4(...)   __VA_ARGS__, __VA_ARGS__, __VA_ARGS__, __VA_ARGS__
+#define REPEAT_256(x)   REPEAT_4(REPEAT_4(REPEAT_4(REPEAT_4(x))))
+
+port_read_handler port_read[256] = { REPEAT_256(unmapped_read) };
+port_write_handler port_write[256] = { REPEAT_256(unmapped_write) };
+
+void io_reset(void) {
+    for (int port = 0; port < 256; port++) {
+        port_read[port] = unmapped_read;
+        port_write[port] = unmapped_write;
+    }
+}
+
+void io_register_read(uint8_t port, port_read_handler handler) {
+    port_read[port] = handler ? handler : unmapped_read;
+}
+
+void io_register_write(uint8_t port, port_write_handler handler) {
+    port_write[port] = handler ? handler : unmapped_write;
+}
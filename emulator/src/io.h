@@ -0,0 +1,22 @@
+#ifndef _IO_H
+#define _IO_H
+
+#include <stdint.h>
+
+// 8080 I/O ports. IN and OUT index straight into these tables and call the
+// handler, so a port access costs one indirect call. Ports nothing has
+// registered read 0 and ignore writes; there is never a NULL entry.
+
+typedef uint8_t (*port_read_handler)(uint8_t port);
+typedef void (*port_write_handler)(uint8_t port, uint8_t value);
+
+extern port_read_handler port_read[256];
+extern port_write_handler port_write[256];
+
+// Points every port back at the unmapped handlers.
+void io_reset(void);
+
+void io_register_read(uint8_t port, port_read_handler handler);
+void io_register_write(uint8_t port, port_write_handler handler);
+
+#endif
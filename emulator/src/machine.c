@@ -0,0 +1,48 @@
+#include <stdint.h>
+
+#include "machine.h"
+#include "display.h"
+#include "timeline.h"
+#include "io.h"
+#include "invaders.h"
+
+void machine_init(void) {
+    io_reset();
+    invaders_attach();
+}
+
+void run_frame(cpu* state) {
+
+    // Start each frame's cycle budget from zero so the interrupts below
+    // fire at the same beam positions every frame.
+    state->total_cpu_cycles = 0;
+
+    // below we're basically using the CPU clock as a way to measure time
+    // the VBLANK_RATE is how many CPU cycles it takes to render a frame
+    // typically the display hardware in the arcade cabinet would be setup to send the interrupt every half scan
+    // obviously we don't have a real display, so we simulate that by allowing the CPU to run what time it takes a half a frame to be rendered
+    // we do that by checking if the number of CPU cycles executed so far is less than the half the amount of cycles it takes to render 1 frame
+
+    // Run the first half of the frame, then the mid-screen interrupt.
+    uint64_t slice_start = timeline_begin();
+    while (state->total_cpu_cycles < (VBLANK_RATE / 2)) {
+        execute(state);
+    }
+    timeline_end("cpu (top half)", slice_start, state->cycle_count);
+    invaders_expire_input();        // the next IN 1 / IN 2 polls again
+    generate_interrupt(state, 1);   // RST 1 -> 0x08 (mid-screen)
+
+    // Run the rest of the frame, then the VBlank interrupt.
+    slice_start = timeline_begin();
+    while (state->total_cpu_cycles < VBLANK_RATE) {
+        execute(state);
+    }
+    timeline_end("cpu (bottom half)", slice_start, state->cycle_count);
+
+    // Sample input at the last moment before the VBlank handler, whether or
+    // not the game read the ports this half. This is also the once-a-frame
+    // poll that keeps the window responsive when nothing reads them.
+    invaders_expire_input();
+    invaders_sample_input();
+    generate_interrupt(state, 2);   // RST 2 -> 0x10 (VBlank)
+}
@@ -0,0 +1,17 @@
+#ifndef _MACHINE_H
+#define _MACHINE_H
+
+#include "cpu.h"
+
+// Space Invaders machine: how the cabinet drives the CPU over one video frame.
+// Shared by the SDL frame loop in main.c and the headless benchmarks.
+
+// Wire up the cabinet's I/O ports and reset its devices. Call before the
+// first frame, and again to start over from reset.
+void machine_init(void);
+
+// Run one frame's worth of cycles, delivering the mid-screen (RST 1) and
+// VBlank (RST 2) interrupts at their beam positions.
+void run_frame(cpu* state);
+
+#endif
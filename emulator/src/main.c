@@ -1,12 +1,25 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#include <signal.h>
+#include <time.h>
 
 #include "cpu.h"
 #include "display.h"
 #include "rom.h"
+#include "profile.h"
+#include "sampler.h"
+#include "metrics.h"
+#include "telemetry.h"
+#include "timeline.h"
+#include "machine.h"
+#include "disasm.h"
+#include "audio.h"
+#include "invaders.h"
 
 const char* version_string = "0.0.3";
 const char* build_date = __DATE__;
@@ -19,14 +32,37 @@ void about_info(void) {
     printf("build date: %s\n", build_date);
 }
 
-// Check command line arguments
+// Check command line arguments. Flags can go anywhere after the program name;
+// the four ROM files are still expected first.
 
-int check_args(char** argv) {
-    if(strcmp(argv[1], "--dumpregisters") == 0) {
+// Returns the index of flag in argv, or 0 if it wasn't passed.
+int find_arg(int argc, char** argv, const char* flag) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], flag) == 0) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+// Returns the argument following flag, or NULL if flag is absent or last.
+char* arg_value(int argc, char** argv, const char* flag) {
+    int i = find_arg(argc, argv, flag);
+
+    if(i == 0 || i + 1 >= argc) {
+        return NULL;
+    }
+
+    return argv[i + 1];
+}
+
+int check_args(int argc, char** argv) {
+    if(find_arg(argc, argv, "--dumpregisters")) {
         return 0;
     }
 
-    if(strcmp(argv[1], "--about") == 0) {
+    if(find_arg(argc, argv, "--about")) {
         return 1;
     }
 
@@ -37,16 +73,72 @@ void handle_args(int argc, char** argv, cpu* state) {
 
     if(argc >= 2) {
         
-        if(check_args(argv) == 0) {
+        if(check_args(argc, argv) == 0) {
             dump_registers(state);
         }
 
-        if(check_args(argv) == 1) {
+        if(check_args(argc, argv) == 1) {
             about_info();
         }
     }
 }
 
+// Sampler output: samples are pulled out of the ring when the process gets
+// SIGUSR1 (e.g. `kill -USR1 <pid>` on a live instance) and again on exit.
+static const char* sample_path = "samples.folded";
+static volatile sig_atomic_t sample_dump_requested = 0;
+
+static void request_sample_dump(int signum) {
+    (void)signum;
+    sample_dump_requested = 1;
+}
+
+static void dump_samples(void) {
+    FILE* out = fopen(sample_path, "a");
+
+    if(!out) {
+        fprintf(stderr, "could not write %s\n", sample_path);
+        return;
+    }
+
+    int drained = sampler_drain(out);
+    fclose(out);
+
+    // samples lost to a full ring, so a thin profile is explained
+    fprintf(stderr, "sampler: %d samples written to %s, %llu dropped so far\n",
+        drained, sample_path, (unsigned long long)sampler_dropped());
+}
+
+static void setup_sampler(int argc, char** argv) {
+    int i = find_arg(argc, argv, "--sample");
+
+    if(!i) {
+        return;
+    }
+
+    // optional period in emulated cycles: --sample 5000
+    int32_t period = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+    sampler_enable(period);
+
+    if(arg_value(argc, argv, "--sample-out")) {
+        sample_path = arg_value(argc, argv, "--sample-out");
+    }
+
+#ifdef SIGUSR1
+    signal(SIGUSR1, request_sample_dump);
+#endif
+}
+
+// Input is polled on demand from the machine (see invaders.h), late in the
+// frame, rather than at the top of the frame loop.
+static cpu* poll_state = NULL;
+
+static void poll_input(void) {
+    uint64_t input_start = timeline_begin();
+    process_input();
+    timeline_end("process_input", input_start, poll_state->cycle_count);
+}
+
 void display_intro() {
 
 	char intro_array[MAX_INTRO_LINES][MAX_INTRO_CHARS];
@@ -71,11 +163,40 @@ void display_intro() {
 	fclose(intro_file);
 }
 
+// With audio on, the frame loop keeps to 60 Hz on the wall clock so the ring
+// neither overflows nor runs dry. The sleep comes after the frame has been
+// presented, so it adds no input-to-photon latency and isn't counted in the
+// frame's metrics. A loop that falls more than a frame behind starts over
+// from now rather than racing to catch up.
+static void pace_frame(void) {
+    static struct timespec deadline;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    deadline.tv_nsec += 1000000000L / REFRESH_RATE;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    int64_t behind = (int64_t)(now.tv_sec - deadline.tv_sec) * 1000000000LL
+        + (now.tv_nsec - deadline.tv_nsec);
+
+    if (behind > 1000000000LL / REFRESH_RATE) {
+        deadline = now;
+        return;
+    }
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+}
+
 int main(int argc, char** argv) {
 
     //display_intro();
 
     cpu* state = init_cpu();
+    machine_init();
 
     // test(state);
 
@@ -100,36 +221,101 @@ int main(int argc, char** argv) {
     }
     running = true;
 
-    while(running) {
-        process_input();
+    default_keymap();
+    if (arg_value(argc, argv, "--keymap")) {
+        load_keymap(arg_value(argc, argv, "--keymap"));
+    }
+
+    poll_state = state;
+    invaders_set_input_poll(poll_input);
 
-        // Start each frame's cycle budget from zero so the interrupts below
-        // fire at the same beam positions every frame.
-        state->total_cpu_cycles = 0;
+    setup_sampler(argc, argv);
 
-        // below we're basically using the CPU clock as a way to measure time
-        // the VBLANK_RATE is how many CPU cycles it takes to render a frame
-        // typically the display hardware in the arcade cabinet would be setup to send the interrupt every half scan
-        // obviously we don't have a real display, so we simulate that by allowing the CPU to run what time it takes a half a frame to be rendered
-        // we do that by checking if the number of CPU cycles executed so far is less than the half the amount of cycles it takes to render 1 frame
+    trace_instructions = find_arg(argc, argv, "--trace");
+
+    // names for --trace and the profile reports
+    static symbol_table symbols;
+    if (arg_value(argc, argv, "--symbols") && symbols_load(&symbols, arg_value(argc, argv, "--symbols"))) {
+        disassemble_use_symbols(&symbols);
+    }
+
+    if (arg_value(argc, argv, "--metrics")) {
+        char* interval = arg_value(argc, argv, "--metrics-interval");
+        metrics_open(arg_value(argc, argv, "--metrics"), interval ? atoi(interval) : 0);
+    }
+
+    // --telemetry [name]: the name is optional, so only take the next
+    // argument when it isn't another flag
+    int telemetry_arg = find_arg(argc, argv, "--telemetry");
+    if (telemetry_arg) {
+        char* name = arg_value(argc, argv, "--telemetry");
+        telemetry_open(name && strncmp(name, "--", 2) != 0 ? name : NULL);
+    }
+
+    if (arg_value(argc, argv, "--timeline")) {
+        timeline_open(arg_value(argc, argv, "--timeline"));
+    }
 
-        // Run the first half of the frame, then the mid-screen interrupt.
-        while (state->total_cpu_cycles < (VBLANK_RATE / 2)) {
-            execute(state);
+    // --audio <sample dir> [--audio-buffer <ms>]
+    if (arg_value(argc, argv, "--audio")) {
+        char* buffer_ms = arg_value(argc, argv, "--audio-buffer");
+
+        if (audio_init(arg_value(argc, argv, "--audio"), buffer_ms ? atoi(buffer_ms) : 0) && !init_audio()) {
+            audio_close();
         }
-        generate_interrupt(state, 1);   // RST 1 -> 0x08 (mid-screen)
+    }
+
+    while(running) {
+        metrics_frame_begin();
+        uint64_t frame_start = timeline_begin();
 
-        // Run the rest of the frame, then the VBlank interrupt.
-        while (state->total_cpu_cycles < VBLANK_RATE) {
-            execute(state);
+        if (sample_dump_requested) {
+            sample_dump_requested = 0;
+            dump_samples();
         }
-        generate_interrupt(state, 2);   // RST 2 -> 0x10 (VBlank)
+
+        metrics_phase_begin(PHASE_CPU);
+        run_frame(state);
+        metrics_phase_end(PHASE_CPU);
+
+        audio_frame();
 
         render(state);
+
+        timeline_end("frame", frame_start, state->cycle_count);
+
+        metrics_frame_end(state);
+        telemetry_publish(state);
+
+        if (audio_enabled) {
+            pace_frame();
+        }
+    }
+
+    metrics_close();
+    telemetry_close();
+    timeline_close();
+
+    if (audio_enabled) {
+        destroy_audio();
+        fprintf(stderr, "audio: %llu underruns, %llu samples dropped\n",
+            (unsigned long long)audio_stats.underruns, (unsigned long long)audio_stats.dropped);
+        audio_close();
     }
 
     handle_args(argc, argv, state);
 
+    if (sampler_enabled) {
+        dump_samples();
+    }
+
+#ifdef PROFILE
+    profile_report(state);
+#endif
+#ifdef PROFILE_CALLGRAPH
+    callgraph_report("callgraph.folded");
+#endif
+
     quit();
 
     return 0;
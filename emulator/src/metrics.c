@@ -0,0 +1,172 @@
+// clock_gettime() is POSIX, not C99
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "metrics.h"
+#include "display.h"
+
+#define FRAME_BUDGET_NS     (1000000000ULL / REFRESH_RATE)
+
+static metrics_counters counters;
+
+static uint64_t frame_start_ns = 0;
+static uint64_t phase_start_ns[PHASE_COUNT];
+static uint64_t frame_phase_ns[PHASE_COUNT];
+
+// Export state. window_* hold the values at the start of the current
+// interval so each row describes just that interval.
+static FILE* metrics_file = NULL;
+static bool metrics_csv = false;
+static int metrics_interval = METRICS_DEFAULT_INTERVAL;
+
+static uint64_t window_start_ns = 0;
+static metrics_counters window_start;
+static uint64_t window_max_frame_ns = 0;
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void metrics_frame_begin(void) {
+    frame_start_ns = metrics_now_ns();
+    memset(frame_phase_ns, 0, sizeof(frame_phase_ns));
+
+    if (window_start_ns == 0) {
+        window_start_ns = frame_start_ns;
+    }
+}
+
+void metrics_phase_begin(metrics_phase phase) {
+    phase_start_ns[phase] = metrics_now_ns();
+}
+
+void metrics_phase_end(metrics_phase phase) {
+    frame_phase_ns[phase] += metrics_now_ns() - phase_start_ns[phase];
+}
+
+static void write_row(uint64_t now) {
+
+    uint64_t frames = counters.frames - window_start.frames;
+    uint64_t wall_ns = now - window_start_ns;
+    uint64_t cycles = counters.cycles - window_start.cycles;
+
+    counters.emulated_mhz = wall_ns ? (double)cycles * 1000.0 / wall_ns : 0.0;
+
+    if (!metrics_file || frames == 0) {
+        return;
+    }
+
+    uint64_t avg_frame = (counters.frame_ns - window_start.frame_ns) / frames;
+    uint64_t avg_cpu = (counters.phase_ns[PHASE_CPU] - window_start.phase_ns[PHASE_CPU]) / frames;
+    uint64_t avg_render = (counters.phase_ns[PHASE_RENDER] - window_start.phase_ns[PHASE_RENDER]) / frames;
+    uint64_t avg_present = (counters.phase_ns[PHASE_PRESENT] - window_start.phase_ns[PHASE_PRESENT]) / frames;
+    uint64_t late = counters.late_frames - window_start.late_frames;
+    uint64_t instructions = counters.instructions - window_start.instructions;
+
+    if (metrics_csv) {
+        fprintf(metrics_file, "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%llu,%llu\n",
+            (unsigned long long)counters.frames,
+            (unsigned long long)frames,
+            (unsigned long long)instructions,
+            (unsigned long long)cycles,
+            (unsigned long long)avg_frame,
+            (unsigned long long)avg_cpu,
+            (unsigned long long)avg_render,
+            (unsigned long long)avg_present,
+            (unsigned long long)window_max_frame_ns,
+            counters.emulated_mhz,
+            (unsigned long long)late,
+            (unsigned long long)counters.late_frames);
+    } else {
+        fprintf(metrics_file,
+            "{\"frame\":%llu,\"frames\":%llu,\"instructions\":%llu,\"cycles\":%llu,"
+            "\"frame_ns\":%llu,\"cpu_ns\":%llu,\"render_ns\":%llu,\"present_ns\":%llu,"
+            "\"max_frame_ns\":%llu,\"emulated_mhz\":%.3f,\"late_frames\":%llu,\"total_late_frames\":%llu}\n",
+            (unsigned long long)counters.frames,
+            (unsigned long long)frames,
+            (unsigned long long)instructions,
+            (unsigned long long)cycles,
+            (unsigned long long)avg_frame,
+            (unsigned long long)avg_cpu,
+            (unsigned long long)avg_render,
+            (unsigned long long)avg_present,
+            (unsigned long long)window_max_frame_ns,
+            counters.emulated_mhz,
+            (unsigned long long)late,
+            (unsigned long long)counters.late_frames);
+    }
+
+    fflush(metrics_file);
+}
+
+void metrics_frame_end(cpu* state) {
+
+    uint64_t now = metrics_now_ns();
+    uint64_t frame_ns = now - frame_start_ns;
+
+    counters.frames++;
+    counters.instructions = state->instruction_count;
+    counters.cycles = state->cycle_count;
+    counters.frame_ns += frame_ns;
+    counters.last_frame_ns = frame_ns;
+
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        counters.phase_ns[i] += frame_phase_ns[i];
+        counters.last_phase_ns[i] = frame_phase_ns[i];
+    }
+
+    if (frame_ns > FRAME_BUDGET_NS) {
+        counters.late_frames++;
+    }
+
+    if (frame_ns > window_max_frame_ns) {
+        window_max_frame_ns = frame_ns;
+    }
+
+    if (counters.frames - window_start.frames >= (uint64_t)metrics_interval) {
+        write_row(now);
+        window_start = counters;
+        window_start_ns = now;
+        window_max_frame_ns = 0;
+    }
+}
+
+const metrics_counters* metrics_get(void) {
+    return &counters;
+}
+
+bool metrics_open(const char* path, int interval) {
+
+    metrics_file = fopen(path, "w");
+
+    if (!metrics_file) {
+        fprintf(stderr, "could not open metrics file %s\n", path);
+        return false;
+    }
+
+    metrics_interval = interval > 0 ? interval : METRICS_DEFAULT_INTERVAL;
+
+    size_t length = strlen(path);
+    metrics_csv = length >= 4 && strcmp(path + length - 4, ".csv") == 0;
+
+    if (metrics_csv) {
+        fprintf(metrics_file, "frame,frames,instructions,cycles,frame_ns,cpu_ns,render_ns,present_ns,"
+            "max_frame_ns,emulated_mhz,late_frames,total_late_frames\n");
+    }
+
+    return true;
+}
+
+void metrics_close(void) {
+    if (metrics_file) {
+        fclose(metrics_file);
+        metrics_file = NULL;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+// Built-in performance counters. The frame loop brackets each frame and its
+// phases; the counters are always collected (a handful of clock reads per
+// frame) and can additionally be exported to a file every N frames.
+
+#define METRICS_DEFAULT_INTERVAL    60      // frames between exported rows
+
+typedef enum {
+    PHASE_CPU,          // execute() between the interrupts
+    PHASE_RENDER,       // VRAM -> host framebuffer conversion
+    PHASE_PRESENT,      // texture upload and SDL present
+    PHASE_COUNT
+} metrics_phase;
+
+typedef struct {
+    // Totals since start
+    uint64_t frames;
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t late_frames;               // frames over the 1/REFRESH_RATE budget
+    uint64_t frame_ns;
+    uint64_t phase_ns[PHASE_COUNT];
+
+    // Most recent frame
+    uint64_t last_frame_ns;
+    uint64_t last_phase_ns[PHASE_COUNT];
+
+    // Emulated clock achieved over the last export interval, in MHz
+    double emulated_mhz;
+} metrics_counters;
+
+uint64_t metrics_now_ns(void);
+
+void metrics_frame_begin(void);
+void metrics_frame_end(cpu* state);
+void metrics_phase_begin(metrics_phase phase);
+void metrics_phase_end(metrics_phase phase);
+
+const metrics_counters* metrics_get(void);
+
+// Start exporting to path every interval frames. A path ending in ".csv"
+// gets CSV with a header row; anything else gets JSON Lines.
+bool metrics_open(const char* path, int interval);
+void metrics_close(void);
+
+#endif
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "profile.h"
+#include "disasm.h"
+#include "../../common/opcodes.h"
+
+#ifdef PROFILE
+
+#define PROFILE_TOP_ADDRESSES   40
+
+uint64_t profile_pc_count[0x10000];
+
+// Filled in by profile_report() from the counts and the opcode at each
+// address; see the note in profile.h.
+static uint64_t pc_cycles[0x10000];
+static uint64_t op_count[256];
+static uint64_t op_cycles[256];
+
+static int compare_pc_cycles(const void* a, const void* b) {
+    uint64_t x = pc_cycles[*(const uint16_t*)a];
+    uint64_t y = pc_cycles[*(const uint16_t*)b];
+    return (x < y) - (x > y);
+}
+
+static int compare_op_cycles(const void* a, const void* b) {
+    uint64_t x = op_cycles[*(const uint8_t*)a];
+    uint64_t y = op_cycles[*(const uint8_t*)b];
+    return (x < y) - (x > y);
+}
+
+void profile_report(cpu* state) {
+
+    uint16_t* hot = malloc(sizeof(uint16_t) * 0x10000);
+    int hot_count = 0;
+
+    uint64_t total_count = 0;
+    uint64_t total_cycles = 0;
+
+    for (int pc = 0; pc < 0x10000; pc++) {
+        if (profile_pc_count[pc] == 0) {
+            continue;
+        }
+
+        hot[hot_count++] = pc;
+
+        // same cycle table as execute(), so conditional CALL/RET are
+        // charged their not-taken cost here too
+        uint8_t op = state->memory[pc];
+        pc_cycles[pc] = profile_pc_count[pc] * opcode_table[op].cycles;
+
+        total_count += profile_pc_count[pc];
+        total_cycles += pc_cycles[pc];
+
+        op_count[op] += profile_pc_count[pc];
+        op_cycles[op] += pc_cycles[pc];
+    }
+
+    if (total_cycles == 0) {
+        free(hot);
+        return;
+    }
+
+    qsort(hot, hot_count, sizeof(uint16_t), compare_pc_cycles);
+
+    printf("\n--- profile: %llu instructions, %llu cycles, %d distinct addresses ---\n",
+        (unsigned long long)total_count, (unsigned long long)total_cycles, hot_count);
+    printf("(cycles and opcodes are taken from memory at exit; code overwritten while\n"
+           " it ran is charged to the bytes left at its address)\n");
+
+    printf("\naddr  %12s %14s %7s  instruction\n", "count", "cycles", "%cyc");
+
+    for (int i = 0; i < hot_count && i < PROFILE_TOP_ADDRESSES; i++) {
+        uint16_t pc = hot[i];
+
+        printf("%04x  %12llu %14llu %6.2f%%  ", pc,
+            (unsigned long long)profile_pc_count[pc],
+            (unsigned long long)pc_cycles[pc],
+            100.0 * pc_cycles[pc] / total_cycles);
+
+        disassemble(&state->memory[pc]);
+    }
+
+    uint8_t ops[256];
+    int op_total = 0;
+
+    for (int op = 0; op < 256; op++) {
+        if (op_count[op] != 0) {
+            ops[op_total++] = op;
+        }
+    }
+
+    qsort(ops, op_total, sizeof(uint8_t), compare_op_cycles);
+
+    printf("\nop    %12s %14s %7s  instruction\n", "count", "cycles", "%cyc");
+
+    for (int i = 0; i < op_total; i++) {
+        // operand bytes are zero, we only want the mnemonic
+        uint8_t opcode[3] = { ops[i], 0, 0 };
+
+        printf("%02x    %12llu %14llu %6.2f%%  ", ops[i],
+            (unsigned long long)op_count[ops[i]],
+            (unsigned long long)op_cycles[ops[i]],
+            100.0 * op_cycles[ops[i]] / total_cycles);
+
+        disassemble(opcode);
+    }
+
+    free(hot);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+// Per-PC instruction profiler and subroutine call-graph profiler. Only
+// compiled into the profiling builds: `make profile` defines PROFILE, and
+// `make profile-callgraph` adds PROFILE_CALLGRAPH. In the normal build the
+// hooks below expand to nothing so execute() pays no cost at all.
+//
+// The per-PC profiler is one increment per instruction. Cycles and opcode
+// totals are worked out at report time from the bytes in memory, so code
+// that was overwritten while it ran is charged to whatever is there at exit.
+// The call graph adds one more read-modify-write per instruction (the
+// current node's cycles) plus a tree lookup on every CALL and RET.
+
+#ifdef PROFILE
+
+// Execution counts, indexed by the 8080 address of the opcode.
+extern uint64_t profile_pc_count[0x10000];
+
+// Print the hot-spot report (hottest addresses and opcodes) to stdout.
+void profile_report(cpu* state);
+
+#ifdef PROFILE_CALLGRAPH
+
+// One node per distinct call path; see callgraph.c.
+typedef struct {
+    uint16_t addr;          // entry address of the routine
+    int8_t irq;             // interrupt number for interrupt roots, -1 otherwise
+    int parent;             // -1 for roots
+    int first_child;
+    int next_sibling;
+    uint64_t calls;
+    uint64_t self_cycles;
+} callgraph_node;
+
+extern callgraph_node callgraph_nodes[];
+extern int callgraph_current;
+
+#define PROFILE_NODE_CYCLES(cycles)     callgraph_nodes[callgraph_current].self_cycles += (cycles)
+#define PROFILE_CALL(state, target)     callgraph_call((state), (target))
+#define PROFILE_RET(state)              callgraph_ret((state))
+#define PROFILE_INTERRUPT(num)          callgraph_interrupt((num))
+
+void callgraph_call(cpu* state, uint16_t target);
+void callgraph_ret(cpu* state);
+void callgraph_interrupt(uint8_t interrupt_num);
+
+// Print per-routine inclusive/exclusive cycles and the hottest call edges to
+// stdout, and write folded stacks (flamegraph.pl / speedscope input) to path.
+void callgraph_report(const char* folded_path);
+
+#else
+
+#define PROFILE_NODE_CYCLES(cycles)
+#define PROFILE_CALL(state, target)
+#define PROFILE_RET(state)
+#define PROFILE_INTERRUPT(num)
+
+#endif
+
+#define PROFILE_INSTRUCTION(pc, cycles)                                 \
+    do {                                                                \
+        profile_pc_count[(pc)]++;                                       \
+        PROFILE_NODE_CYCLES(cycles);                                    \
+    } while (0)
+
+#else
+
+#define PROFILE_INSTRUCTION(pc, cycles)
+#define PROFILE_CALL(state, target)
+#define PROFILE_RET(state)
+#define PROFILE_INTERRUPT(num)
+
+#endif
+
+#endif
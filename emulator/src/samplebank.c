@@ -0,0 +1,309 @@
+// mmap() and stat() are POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "samplebank.h"
+
+static const char bank_magic[8] = { '8', '0', '8', '0', 'S', 'N', 'D', SAMPLEBANK_VERSION };
+
+// Sample data starts on a 64-byte boundary after the header and table.
+static size_t data_start(int count) {
+    return (16 + 8 * (size_t)count + 63) & ~(size_t)63;
+}
+
+static uint32_t read_le(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = value << 8 | p[i];
+    }
+    return value;
+}
+
+static void write_le32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = value >> (8 * i);
+    }
+}
+
+// Minimal RIFF/WAVE reader: 8- or 16-bit integer PCM, any rate, mono or the
+// first channel of a multi-channel file. Returns malloc'd samples.
+static int16_t* load_wav(const char* path, uint32_t* length, uint32_t* rate) {
+
+    FILE* file = fopen(path, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    uint8_t* bytes = malloc(size > 0 ? size : 1);
+    int ok = size > 12 && fread(bytes, 1, size, file) == (size_t)size
+        && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WAVE", 4) == 0;
+
+    fclose(file);
+
+    uint32_t channels = 0, bits = 0;
+    const uint8_t* pcm = NULL;
+    uint32_t pcm_bytes = 0;
+    int16_t* out = NULL;
+
+    *rate = 0;
+
+    for (long at = 12; ok && at + 8 <= size; ) {
+        uint32_t chunk = read_le(bytes + at + 4, 4);
+
+        if (chunk > (uint32_t)(size - at - 8)) {
+            chunk = size - at - 8;
+        }
+
+        if (memcmp(bytes + at, "fmt ", 4) == 0 && chunk >= 16) {
+            ok = read_le(bytes + at + 8, 2) == 1;
+            channels = read_le(bytes + at + 10, 2);
+            *rate = read_le(bytes + at + 12, 4);
+            bits = read_le(bytes + at + 22, 2);
+        } else if (memcmp(bytes + at, "data", 4) == 0) {
+            pcm = bytes + at + 8;
+            pcm_bytes = chunk;
+        }
+
+        at += 8 + chunk + (chunk & 1);
+    }
+
+    if (ok && pcm && channels && *rate && (bits == 8 || bits == 16)) {
+        uint32_t frame_bytes = channels * bits / 8;
+
+        *length = pcm_bytes / frame_bytes;
+        out = malloc(sizeof(int16_t) * (*length ? *length : 1));
+
+        for (uint32_t i = 0; i < *length; i++) {
+            const uint8_t* frame = pcm + i * frame_bytes;
+            out[i] = bits == 8 ? (int16_t)((frame[0] - 128) << 8) : (int16_t)read_le(frame, 2);
+        }
+    }
+
+    free(bytes);
+
+    return out;
+}
+
+// Linear-interpolation resample into `out`, which has room for the result.
+static uint32_t resample(const int16_t* in, uint32_t length, uint32_t from, uint32_t to, int16_t* out) {
+
+    uint32_t result = (uint32_t)((uint64_t)length * to / from);
+    uint64_t step = ((uint64_t)from << 16) / to;
+
+    for (uint32_t i = 0; i < result; i++) {
+        uint64_t position = i * step;
+        uint32_t index = position >> 16;
+        int32_t fraction = position & 0xFFFF;
+        int32_t a = in[index];
+        int32_t b = index + 1 < length ? in[index + 1] : a;
+
+        out[i] = a + (((b - a) * fraction) >> 16);
+    }
+
+    return result;
+}
+
+// Fills bank->samples from a bank image; false if the image doesn't hold up.
+static bool attach_image(sample_bank* bank, const uint8_t* image, size_t size, int count, uint32_t rate) {
+
+    size_t start = data_start(count);
+
+    if (size < start || memcmp(image, bank_magic, 8) != 0
+        || read_le(image + 8, 4) != rate || read_le(image + 12, 4) != (uint32_t)count) {
+        return false;
+    }
+
+    size_t data_samples = (size - start) / sizeof(int16_t);
+
+    for (int i = 0; i < count; i++) {
+        uint32_t offset = read_le(image + 16 + 8 * i, 4);
+        uint32_t length = read_le(image + 20 + 8 * i, 4);
+
+        if ((uint64_t)offset + length + SAMPLEBANK_PADDING > data_samples) {
+            return false;
+        }
+
+        bank->samples[i].data = length ? (const int16_t*)(image + start) + offset : NULL;
+        bank->samples[i].length = length;
+    }
+
+    return true;
+}
+
+// Decodes every WAV into a fresh bank image. Returns it malloc'd.
+static uint8_t* build_image(const char* dir, int count, uint32_t rate, size_t* size) {
+
+    int16_t* decoded[SAMPLEBANK_MAX] = { NULL };
+    uint32_t lengths[SAMPLEBANK_MAX] = { 0 };
+    uint32_t rates[SAMPLEBANK_MAX] = { 0 };
+    size_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        char path[1024];
+
+        snprintf(path, sizeof(path), "%s/%d.wav", dir, i);
+        decoded[i] = load_wav(path, &lengths[i], &rates[i]);
+
+        if (!decoded[i]) {
+            fprintf(stderr, "audio: no sample %s\n", path);
+            lengths[i] = 0;
+            continue;
+        }
+
+        total += (uint64_t)lengths[i] * rate / rates[i] + SAMPLEBANK_PADDING;
+    }
+
+    size_t start = data_start(count);
+    uint8_t* image;
+
+    *size = start + total * sizeof(int16_t);
+    image = calloc(*size, 1);
+
+    memcpy(image, bank_magic, 8);
+    write_le32(image + 8, rate);
+    write_le32(image + 12, count);
+
+    int16_t* data = (int16_t*)(image + start);
+    uint32_t offset = 0;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t length = 0;
+
+        write_le32(image + 16 + 8 * i, offset);
+
+        if (decoded[i]) {
+            length = resample(decoded[i], lengths[i], rates[i], rate, data + offset);
+            free(decoded[i]);
+
+            // the padding after each sample is already zero
+            offset += length + SAMPLEBANK_PADDING;
+        }
+
+        write_le32(image + 20 + 8 * i, length);
+    }
+
+    return image;
+}
+
+// Is the bank file at least as new as every WAV it came from?
+static bool bank_current(const char* bank_path, const char* dir, int count) {
+
+    struct stat bank_info;
+
+    if (stat(bank_path, &bank_info) != 0) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char path[1024];
+        struct stat info;
+
+        snprintf(path, sizeof(path), "%s/%d.wav", dir, i);
+
+        if (stat(path, &info) == 0 && info.st_mtime > bank_info.st_mtime) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool map_bank(sample_bank* bank, const char* path, int count, uint32_t rate) {
+
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    if (!attach_image(bank, map, info.st_size, count, rate)) {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    bank->map = map;
+    bank->map_size = info.st_size;
+    bank->mapped = true;
+
+    return true;
+}
+
+int samplebank_open(sample_bank* bank, const char* dir, int count, uint32_t rate) {
+
+    char path[1024];
+    char temp[1100];
+
+    memset(bank, 0, sizeof(*bank));
+    bank->count = count < SAMPLEBANK_MAX ? count : SAMPLEBANK_MAX;
+
+    snprintf(path, sizeof(path), "%s/samples.bank", dir);
+
+    if (!bank_current(path, dir, bank->count) || !map_bank(bank, path, bank->count, rate)) {
+        size_t size;
+        uint8_t* image = build_image(dir, bank->count, rate, &size);
+
+        // write-then-rename, so another instance never maps half a file
+        snprintf(temp, sizeof(temp), "%s.%ld", path, (long)getpid());
+        FILE* file = fopen(temp, "wb");
+        bool written = file && fwrite(image, 1, size, file) == size;
+
+        if (file) {
+            written = fclose(file) == 0 && written;
+        }
+
+        if (written && rename(temp, path) == 0 && map_bank(bank, path, bank->count, rate)) {
+            free(image);
+        } else {
+            remove(temp);
+            attach_image(bank, image, size, bank->count, rate);
+            bank->map = image;
+            bank->map_size = size;
+            bank->mapped = false;
+        }
+    }
+
+    int found = 0;
+
+    for (int i = 0; i < bank->count; i++) {
+        found += bank->samples[i].data != NULL;
+    }
+
+    return found;
+}
+
+void samplebank_close(sample_bank* bank) {
+
+    if (bank->mapped) {
+        munmap(bank->map, bank->map_size);
+    } else {
+        free(bank->map);
+    }
+
+    memset(bank, 0, sizeof(*bank));
+}
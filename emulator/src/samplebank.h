@@ -0,0 +1,42 @@
+#ifndef _SAMPLEBANK_H
+#define _SAMPLEBANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// The sound samples, decoded once to 16-bit mono at AUDIO_RATE and kept in
+// <dir>/samples.bank, which is mmap'd read-only at startup. Running instances
+// share the same pages. The bank is rebuilt from 0.wav .. N.wav when it is
+// missing, older than one of them, or was made for another output rate. If
+// it can't be written, the decoded samples are kept in memory instead.
+//
+// File layout (little-endian):
+//   "8080SND" + version byte, u32 rate, u32 count
+//   count x { u32 offset, u32 length }     in samples, from the data start
+//   int16 data; every sample is followed by SAMPLEBANK_PADDING zeros, so
+//   the mixer can load whole vectors past the end of a sample.
+
+#define SAMPLEBANK_VERSION  1
+#define SAMPLEBANK_MAX      16
+#define SAMPLEBANK_PADDING  16
+
+typedef struct {
+    const int16_t* data;    // NULL for a sample that wasn't found
+    uint32_t length;
+} bank_sample;
+
+typedef struct {
+    bank_sample samples[SAMPLEBANK_MAX];
+    int count;
+    void* map;
+    size_t map_size;
+    bool mapped;            // false: map is a malloc'd fallback
+} sample_bank;
+
+// Opens (building if needed) the bank for `count` samples in `dir`. Returns
+// the number of samples that have data.
+int samplebank_open(sample_bank* bank, const char* dir, int count, uint32_t rate);
+void samplebank_close(sample_bank* bank);
+
+#endif
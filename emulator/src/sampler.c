@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "sampler.h"
+
+// Samples travel from the emulation thread to the reader through a
+// single-producer/single-consumer ring. head is only written by
+// sampler_take(), tail only by sampler_drain(); each side publishes its
+// index with a release store and reads the other's with an acquire load,
+// so neither ever takes a lock. A full ring drops the new sample.
+#define SAMPLE_RING_SIZE    4096    // must be a power of two
+
+static sample ring[SAMPLE_RING_SIZE];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+static uint64_t dropped = 0;
+
+static int32_t period = SAMPLER_DEFAULT_PERIOD;
+
+bool sampler_enabled = false;
+int32_t sampler_countdown = INT32_MAX;
+
+typedef struct {
+    uint16_t target;
+    uint16_t sp;                        // 8080 SP with the return address pushed
+} shadow_frame;
+
+static shadow_frame shadow_stack[SAMPLER_STACK_SLOTS];
+static uint32_t shadow_depth = 0;
+
+void sampler_enable(int32_t sample_period) {
+    period = sample_period > 0 ? sample_period : SAMPLER_DEFAULT_PERIOD;
+    shadow_depth = 0;
+    sampler_enabled = true;
+    sampler_countdown = period;
+}
+
+void sampler_disable(void) {
+    sampler_enabled = false;
+    sampler_countdown = INT32_MAX;
+}
+
+void sampler_take(uint16_t pc) {
+
+    if (!sampler_enabled) {
+        // the disabled countdown ran out after ~2^31 cycles, just rearm it
+        sampler_countdown = INT32_MAX;
+        return;
+    }
+
+    sampler_countdown += period;
+
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail == SAMPLE_RING_SIZE) {
+        dropped++;
+        return;
+    }
+
+    sample* s = &ring[head & (SAMPLE_RING_SIZE - 1)];
+    s->pc = pc;
+    s->depth = shadow_depth < SAMPLER_STACK_DEPTH ? shadow_depth : SAMPLER_STACK_DEPTH;
+
+    for (int i = 0; i < s->depth; i++) {
+        s->stack[i] = shadow_stack[shadow_depth - 1 - i].target;
+    }
+
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+}
+
+// A frame is live while its return address is still on the 8080 stack, so
+// every frame whose SP is at or below `sp` is dropped. Unlike matching return
+// addresses this also catches frames whose return address was popped and
+// never returned through.
+static void unwind_to(uint16_t sp) {
+    while (shadow_depth > 0 && shadow_stack[shadow_depth - 1].sp <= sp) {
+        shadow_depth--;
+    }
+}
+
+// Samples only record the innermost frames, so a full stack gives up its
+// outermost one to make room.
+void sampler_call(cpu* state, uint16_t target) {
+
+    unwind_to(state->SP);
+
+    if (shadow_depth == SAMPLER_STACK_SLOTS) {
+        memmove(shadow_stack, shadow_stack + 1, sizeof(shadow_frame) * (SAMPLER_STACK_SLOTS - 1));
+        shadow_depth--;
+    }
+
+    shadow_stack[shadow_depth].target = target;
+    shadow_stack[shadow_depth].sp = state->SP;
+    shadow_depth++;
+}
+
+// After a RET the frame it returned from sits just below SP.
+void sampler_ret(cpu* state) {
+    unwind_to(state->SP - 1);
+}
+
+int sampler_drain(FILE* out) {
+
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    int drained = 0;
+
+    while (tail != head) {
+        sample* s = &ring[tail & (SAMPLE_RING_SIZE - 1)];
+
+        // folded-stack line, outermost frame first; same labels as callgraph.c
+        for (int i = s->depth - 1; i >= 0; i--) {
+            fprintf(out, "sub_%04x;", s->stack[i]);
+        }
+        fprintf(out, "%04x 1\n", s->pc);
+
+        tail++;
+        drained++;
+    }
+
+    __atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+
+    return drained;
+}
+
+uint64_t sampler_dropped(void) {
+    return dropped;
+}
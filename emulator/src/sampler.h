@@ -0,0 +1,69 @@
+#ifndef _SAMPLER_H
+#define _SAMPLER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+// Statistical PC sampler. Unlike the profiling build this is always compiled
+// in: execute() subtracts each instruction's cycles from a countdown and only
+// calls out when it crosses zero, so leaving it on costs one subtract and
+// branch per instruction. While disabled the countdown sits near INT32_MAX.
+
+#define SAMPLER_DEFAULT_PERIOD  20000   // emulated cycles, ~100 samples/s at 2 MHz
+#define SAMPLER_STACK_DEPTH     4       // shadow frames recorded per sample
+#define SAMPLER_STACK_SLOTS     16      // shadow frames kept, innermost first;
+                                        // must be >= SAMPLER_STACK_DEPTH
+
+typedef struct {
+    uint16_t pc;
+    uint8_t depth;                      // frames valid in stack[], innermost first
+    uint16_t stack[SAMPLER_STACK_DEPTH];
+} sample;
+
+extern bool sampler_enabled;
+extern int32_t sampler_countdown;
+
+#define SAMPLER_TICK(pc, cycles)                            \
+    do {                                                    \
+        if ((sampler_countdown -= (cycles)) <= 0) {         \
+            sampler_take((pc));                             \
+        }                                                   \
+    } while (0)
+
+// Bounded shadow call stack, kept by sampler_call()/sampler_ret() only while
+// the sampler is on. Frames are unwound by the 8080 stack pointer rather than
+// counted, so code that drops its return address (POP H then JMP, or a PCHL
+// "return") can't leave stale frames behind: once SP is back above a frame's
+// return address, the frame is gone. The hooks sit where PROFILE_CALL and
+// PROFILE_RET do: after the return address is pushed, and after a taken RET
+// has loaded PC.
+#define SAMPLER_CALL(state, target)                         \
+    do {                                                    \
+        if (sampler_enabled) {                              \
+            sampler_call((state), (target));                \
+        }                                                   \
+    } while (0)
+
+#define SAMPLER_RET(state)                                  \
+    do {                                                    \
+        if (sampler_enabled) {                              \
+            sampler_ret((state));                           \
+        }                                                   \
+    } while (0)
+
+void sampler_enable(int32_t period);
+void sampler_disable(void);
+void sampler_take(uint16_t pc);
+void sampler_call(cpu* state, uint16_t target);
+void sampler_ret(cpu* state);
+
+// Consumer side of the sample ring. Safe to call from one thread other than
+// the emulation thread; writes one folded-stack line per sample and returns
+// how many samples were drained.
+int sampler_drain(FILE* out);
+uint64_t sampler_dropped(void);
+
+#endif
@@ -0,0 +1,102 @@
+// shm_open(), ftruncate() and mmap() are POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "telemetry.h"
+#include "metrics.h"
+
+static telemetry_segment* segment = NULL;
+static char segment_name[64];
+
+bool telemetry_open(const char* name) {
+
+    if (name) {
+        snprintf(segment_name, sizeof(segment_name), "%s%s", name[0] == '/' ? "" : "/", name);
+    } else {
+        snprintf(segment_name, sizeof(segment_name), TELEMETRY_NAME_PREFIX "%d", (int)getpid());
+    }
+
+    int fd = shm_open(segment_name, O_CREAT | O_RDWR, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "could not create telemetry segment %s\n", segment_name);
+        return false;
+    }
+
+    if (ftruncate(fd, sizeof(telemetry_segment)) != 0) {
+        fprintf(stderr, "could not size telemetry segment %s\n", segment_name);
+        close(fd);
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    segment = mmap(NULL, sizeof(telemetry_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (segment == MAP_FAILED) {
+        segment = NULL;
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    memset(segment, 0, sizeof(telemetry_segment));
+    segment->pid = getpid();
+    segment->version = TELEMETRY_VERSION;
+
+    // magic last, so a reader that maps us early never sees a half-built header
+    __atomic_store_n(&segment->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+
+    printf("telemetry: %s\n", segment_name);
+
+    return true;
+}
+
+void telemetry_publish(cpu* state) {
+
+    if (!segment) {
+        return;
+    }
+
+    // Build the payload off to the side so the odd-seq window is one copy.
+    const metrics_counters* counters = metrics_get();
+    telemetry_payload payload;
+
+    payload.frame = counters->frames;
+    payload.instructions = state->instruction_count;
+    payload.cycles = state->cycle_count;
+    payload.late_frames = counters->late_frames;
+    payload.frame_ns = counters->last_frame_ns;
+    payload.cpu_ns = counters->last_phase_ns[PHASE_CPU];
+    payload.render_ns = counters->last_phase_ns[PHASE_RENDER];
+    payload.present_ns = counters->last_phase_ns[PHASE_PRESENT];
+    payload.emulated_mhz = counters->emulated_mhz;
+    payload.PC = state->PC;
+    payload.SP = state->SP;
+    memcpy(payload.hiscore, &state->memory[TELEMETRY_HISCORE_ADDR], 2);
+    memcpy(payload.p1_score, &state->memory[TELEMETRY_P1SCORE_ADDR], 2);
+    memcpy(payload.p2_score, &state->memory[TELEMETRY_P2SCORE_ADDR], 2);
+
+    uint32_t seq = segment->seq;
+
+    __atomic_store_n(&segment->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    segment->payload = payload;
+
+    __atomic_store_n(&segment->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void telemetry_close(void) {
+    if (segment) {
+        munmap(segment, sizeof(telemetry_segment));
+        shm_unlink(segment_name);
+        segment = NULL;
+    }
+}
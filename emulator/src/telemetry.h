@@ -0,0 +1,77 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+// Live telemetry published in a POSIX shared-memory segment, one per running
+// emulator, so an external monitor (tools/shmtail.c) can map any number of
+// instances and poll them with plain memory reads.
+//
+// The payload is guarded by a seqlock: the writer makes seq odd, copies the
+// payload in, then makes seq even again. A reader copies the payload out and
+// retries if seq was odd or changed while it was copying. The emulator never
+// waits on a reader.
+
+#define TELEMETRY_MAGIC         0x30383038      // "8080"
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_NAME_PREFIX   "/8080-"        // default name is this + pid
+
+// Space Invaders keeps its scores as BCD pairs in work RAM.
+#define TELEMETRY_HISCORE_ADDR  0x20F4
+#define TELEMETRY_P1SCORE_ADDR  0x20F8
+#define TELEMETRY_P2SCORE_ADDR  0x20FC
+
+typedef struct {
+    uint64_t frame;
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t late_frames;
+    uint64_t frame_ns;                  // most recent frame and its phases
+    uint64_t cpu_ns;
+    uint64_t render_ns;
+    uint64_t present_ns;
+    double emulated_mhz;
+    uint16_t PC;
+    uint16_t SP;
+    uint8_t hiscore[2];
+    uint8_t p1_score[2];
+    uint8_t p2_score[2];
+} telemetry_payload;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pid;
+    uint32_t seq;
+    telemetry_payload payload;
+} telemetry_segment;
+
+// Create and map the segment. name may be NULL for the pid-based default.
+bool telemetry_open(const char* name);
+void telemetry_publish(cpu* state);
+void telemetry_close(void);
+
+// Reader side: take a consistent copy of the payload. Returns false if the
+// segment doesn't look like ours.
+static inline bool telemetry_read(const telemetry_segment* segment, telemetry_payload* out) {
+
+    if (segment->magic != TELEMETRY_MAGIC || segment->version != TELEMETRY_VERSION) {
+        return false;
+    }
+
+    uint32_t before, after;
+
+    do {
+        before = __atomic_load_n(&segment->seq, __ATOMIC_ACQUIRE);
+        *out = segment->payload;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&segment->seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    return true;
+}
+
+#endif
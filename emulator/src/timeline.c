@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "timeline.h"
+#include "metrics.h"
+
+#define TIMELINE_BUFFER_SIZE    (1 << 20)
+#define TIMELINE_MAX_EVENT      256     // flush when less than this is left
+
+bool timeline_enabled = false;
+
+static FILE* timeline_file = NULL;
+static char buffer[TIMELINE_BUFFER_SIZE];
+static size_t buffer_used = 0;
+static uint64_t origin_ns = 0;
+
+static void flush_buffer(void) {
+    fwrite(buffer, 1, buffer_used, timeline_file);
+    buffer_used = 0;
+}
+
+// Every event after the first metadata record is preceded by a comma, so the
+// array stays valid JSON without tracking whether an event is the first.
+static void append_event(const char* phase, const char* name, uint64_t start_ns, uint64_t dur_ns, uint64_t cycle) {
+
+    if (buffer_used > TIMELINE_BUFFER_SIZE - TIMELINE_MAX_EVENT) {
+        flush_buffer();
+    }
+
+    uint64_t ts_ns = start_ns - origin_ns;
+    char* out = buffer + buffer_used;
+    int written;
+
+    if (phase[0] == 'X') {
+        written = sprintf(out,
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"args\":{\"cycle\":%llu}}",
+            name,
+            (unsigned long long)(ts_ns / 1000), (unsigned)(ts_ns % 1000),
+            (unsigned long long)(dur_ns / 1000), (unsigned)(dur_ns % 1000),
+            (unsigned long long)cycle);
+    } else {
+        written = sprintf(out,
+            ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%llu.%03u,\"args\":{\"cycle\":%llu}}",
+            name,
+            (unsigned long long)(ts_ns / 1000), (unsigned)(ts_ns % 1000),
+            (unsigned long long)cycle);
+    }
+
+    buffer_used += written;
+}
+
+bool timeline_open(const char* path) {
+
+    timeline_file = fopen(path, "w");
+
+    if (!timeline_file) {
+        fprintf(stderr, "could not open timeline file %s\n", path);
+        return false;
+    }
+
+    origin_ns = metrics_now_ns();
+
+    buffer_used = sprintf(buffer,
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"8080\"}}");
+
+    timeline_enabled = true;
+
+    return true;
+}
+
+void timeline_close(void) {
+
+    if (!timeline_file) {
+        return;
+    }
+
+    timeline_enabled = false;
+
+    buffer_used += sprintf(buffer + buffer_used, "\n]}\n");
+    flush_buffer();
+
+    fclose(timeline_file);
+    timeline_file = NULL;
+}
+
+uint64_t timeline_begin(void) {
+    return timeline_enabled ? metrics_now_ns() : 0;
+}
+
+void timeline_end(const char* name, uint64_t start_ns, uint64_t cycle) {
+    if (timeline_enabled) {
+        append_event("X", name, start_ns, metrics_now_ns() - start_ns, cycle);
+    }
+}
+
+void timeline_instant(const char* name, uint64_t cycle) {
+    if (timeline_enabled) {
+        append_event("i", name, metrics_now_ns(), 0, cycle);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef _TIMELINE_H
+#define _TIMELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Optional trace-event timeline (the JSON format chrome://tracing and
+// Perfetto load). Spans carry host timestamps and the emulated cycle count
+// as an argument. Events are formatted into a large in-memory buffer and
+// written out in big chunks; when the timeline is off every hook is a
+// single branch on timeline_enabled.
+
+extern bool timeline_enabled;
+
+bool timeline_open(const char* path);
+void timeline_close(void);
+
+// timeline_begin() returns the span's start time; pass it back to
+// timeline_end() together with a static name.
+uint64_t timeline_begin(void);
+void timeline_end(const char* name, uint64_t start_ns, uint64_t cycle);
+void timeline_instant(const char* name, uint64_t cycle);
+
+#endif
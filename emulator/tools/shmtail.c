@@ -0,0 +1,146 @@
+// shmtail - follow the live telemetry segments of running emulators.
+//
+//   shmtail                 every /8080-* segment found in /dev/shm
+//   shmtail <name> ...      just the named segments (e.g. 8080-1234)
+//
+// Each segment is mapped once; after that polling is plain memory reads,
+// so watching hundreds of instances costs no syscalls beyond the sleep.
+
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../src/telemetry.h"
+
+#define MAX_SEGMENTS    1024
+#define POLL_MS         500
+
+typedef struct {
+    char name[64];
+    const telemetry_segment* segment;
+    uint64_t last_frame;
+} watched;
+
+static watched segments[MAX_SEGMENTS];
+static int segment_count = 0;
+
+static void watch(const char* name) {
+
+    if (segment_count == MAX_SEGMENTS) {
+        return;
+    }
+
+    watched* w = &segments[segment_count];
+    snprintf(w->name, sizeof(w->name), "%s%s", name[0] == '/' ? "" : "/", name);
+
+    int fd = shm_open(w->name, O_RDONLY, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "no telemetry segment %s\n", w->name);
+        return;
+    }
+
+    // a segment the emulator has only just created may not be sized yet, and
+    // reading past the end of a short one would SIGBUS
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(telemetry_segment)) {
+        fprintf(stderr, "telemetry segment %s is too small, skipped\n", w->name);
+        close(fd);
+        return;
+    }
+
+    void* map = mmap(NULL, sizeof(telemetry_segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    w->segment = map;
+    w->last_frame = 0;
+    segment_count++;
+}
+
+static void watch_all(void) {
+    DIR* dir = opendir("/dev/shm");
+
+    if (!dir) {
+        return;
+    }
+
+    // /dev/shm lists the names without the leading slash
+    const char* prefix = TELEMETRY_NAME_PREFIX + 1;
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) {
+            watch(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+}
+
+int main(int argc, char** argv) {
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            watch(argv[i]);
+        }
+    } else {
+        watch_all();
+    }
+
+    if (segment_count == 0) {
+        printf("usage: shmtail [segment ...]\n");
+        return 1;
+    }
+
+    printf("%-16s %7s %10s %8s %8s %8s %8s %5s  %4s %4s  %4s %4s %4s\n",
+        "segment", "pid", "frame", "mhz", "frame_us", "cpu_us", "rend_us", "late",
+        "pc", "sp", "hi", "p1", "p2");
+
+    struct timespec poll = { 0, POLL_MS * 1000000L };
+
+    for (;;) {
+        for (int i = 0; i < segment_count; i++) {
+            watched* w = &segments[i];
+            telemetry_payload p;
+
+            if (!telemetry_read(w->segment, &p) || p.frame == w->last_frame) {
+                continue;
+            }
+
+            w->last_frame = p.frame;
+
+            // scores are little-endian BCD, so print high byte first
+            printf("%-16s %7u %10llu %8.3f %8llu %8llu %8llu %5llu  %04x %04x  %02x%02x %02x%02x %02x%02x\n",
+                w->name, w->segment->pid,
+                (unsigned long long)p.frame, p.emulated_mhz,
+                (unsigned long long)(p.frame_ns / 1000),
+                (unsigned long long)(p.cpu_ns / 1000),
+                (unsigned long long)((p.render_ns + p.present_ns) / 1000),
+                (unsigned long long)p.late_frames,
+                p.PC, p.SP,
+                p.hiscore[1], p.hiscore[0],
+                p.p1_score[1], p.p1_score[0],
+                p.p2_score[1], p.p2_score[0]);
+        }
+
+        fflush(stdout);
+        nanosleep(&poll, NULL);
+    }
+
+    return 0;
+}